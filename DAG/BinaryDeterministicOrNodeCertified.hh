@@ -100,6 +100,18 @@ public:
     out << "0" << endl;
   }// printNNF
 
+  inline unsigned writeBinaryNNF(BinaryNNFWriter &w)
+  {
+    if(this->isWritten()) return this->getWrittenIdx();
+
+    unsigned idxFirst = (firstBranch.d)->writeBinaryNNF(w);
+    unsigned idxSecond = (secondBranch.d)->writeBinaryNNF(w);
+    unsigned idxCurrent = w.addNode('o');
+    firstBranch.addArc(w, idxFirst);
+    secondBranch.addArc(w, idxSecond);
+    return this->setWrittenIdx(idxCurrent);
+  }// writeBinaryNNF
+
 
   inline bool isSAT()
   {
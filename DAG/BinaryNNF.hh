@@ -0,0 +1,872 @@
+/*
+* d4
+* Copyright (C) 2020  Univ. Artois & CNRS
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef DAG_BinaryNNF_h
+#define DAG_BinaryNNF_h
+
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "../utils/SolverTypes.hh"
+#include "../mtl/Vec.hh"
+
+#define BINARY_NNF_MAGIC "d4dDNNF"
+#define BINARY_NNF_VERSION 1
+#define BINARY_NNF_LANES 8  // queries counted together by BinaryNNFLanes
+
+/**
+   Binary representation of a decision-DNNF, made to be mapped in
+   memory and used without any copy. The nodes are numbered such that
+   the children of a node have smaller indexes than it (the root is the
+   last node), then the circuit is evaluated by one pass on the nodes.
+   After the header, the sections are (each one starts on 8 bytes):
+
+   - kind[nbNode]: 'o', 'a', 't' or 'f' as in the text format;
+   - firstArc[nbNode + 1]: the arcs of node i are firstArc[i] .. firstArc[i + 1] - 1;
+   - child[nbArc]: the target of each arc;
+   - firstData[nbArc + 1], data[nbData]: for each arc, its unit literals
+     (DIMACS) and, if it has free variables, 0 followed by them (DIMACS);
+   - weights[2 * nbVar]: the weight of each literal (toInt(l));
+   - projected[nbVar]: 1 if the variable is projected.
+
+   The free variables, the weights and the projected variables are not
+   in the text format, they are needed to get back the model count. The
+   certification information (-drat) is not stored.
+ */
+struct BinaryNNFHeader
+{
+  char magic[8];
+  uint32_t version, nbVar;
+  uint64_t nbNode, nbArc, nbData;
+};
+
+
+/**
+   Build the binary representation: each node is added after its
+   children (see DAG::writeBinaryNNF) and is directly followed by its
+   arcs.
+ */
+class BinaryNNFWriter
+{
+  std::vector<uint8_t> kind;
+  std::vector<uint64_t> firstArc, firstData;
+  std::vector<uint32_t> child;
+  std::vector<int32_t> data;
+
+  template<class E> static void appendSection(std::vector<uint64_t> &buf, const E *data, uint64_t nb)
+  {
+    uint64_t sz = nb * sizeof(E), pos = buf.size();
+    buf.resize(pos + ((sz + 7) >> 3), 0);
+    if(sz) memcpy(&buf[pos], data, sz);
+  }// appendSection
+
+public:
+  BinaryNNFWriter()
+  {
+    firstArc.push_back(0);
+    firstData.push_back(0);
+  }
+
+  inline unsigned addNode(char k)
+  {
+    kind.push_back(k);
+    firstArc.push_back(firstArc.back());
+    return kind.size() - 1;
+  }// addNode
+
+  /**
+     Add an arc to the last node.
+
+     @param[in] idxChild, the index of the target
+     @param[in] units, the unit literals terminated by lit_Undef (or NULL)
+     @param[in] free, the free variables terminated by var_Undef (or NULL)
+   */
+  inline void addArc(unsigned idxChild, const Lit *units, const Var *free)
+  {
+    firstArc.back()++;
+    child.push_back(idxChild);
+    for( ; units && *units != lit_Undef ; units++) data.push_back(readableLit(*units));
+    if(free && *free != var_Undef)
+      {
+        data.push_back(0);
+        for( ; *free != var_Undef ; free++) data.push_back(*free + 1);
+      }
+    firstData.push_back(data.size());
+  }// addArc
+
+  inline uint64_t getNbNode(){return kind.size();}
+  inline uint64_t getNbArc(){return child.size();}
+
+  /**
+     Write the file.
+
+     @param[in] fileName, the path
+     @param[in] weights, the weight of the literals
+     @param[in] projected, the projected variables (at least one per variable)
+     \return false if the file cannot be written
+   */
+  bool save(const char *fileName, vec<double> &weights, vec<bool> &projected)
+  {
+    FILE *f = fopen(fileName, "wb");
+    if(!f) return false;
+
+    bool ok = save(f, weights, projected);
+    return (fclose(f) == 0) && ok;
+  }// save
+
+  /**
+     Write the binary representation at the current position of f (the
+     file is not closed).
+   */
+  bool save(FILE *f, vec<double> &weights, vec<bool> &projected)
+  {
+    std::vector<uint64_t> buf;
+    freeze(buf, weights, projected);
+    return fwrite(buf.data(), sizeof(uint64_t), buf.size(), f) == buf.size() && fflush(f) == 0;
+  }// save
+
+  /**
+     Build the binary representation in memory (in words of 8 bytes,
+     the sections are then aligned), see BinaryNNFMapping::freeze.
+   */
+  void freeze(std::vector<uint64_t> &buf, vec<double> &weights, vec<bool> &projected)
+  {
+    BinaryNNFHeader h;
+    memset(&h, 0, sizeof(h));
+    strcpy(h.magic, BINARY_NNF_MAGIC);
+    h.version = BINARY_NNF_VERSION;
+    h.nbVar = weights.size() >> 1;
+    h.nbNode = kind.size();
+    h.nbArc = child.size();
+    h.nbData = data.size();
+
+    std::vector<uint8_t> proj(h.nbVar);
+    for(unsigned i = 0 ; i<h.nbVar ; i++) proj[i] = projected[i];
+
+    buf.clear();
+    buf.reserve((sizeof(h) + h.nbNode * 17 + h.nbArc * 20 + h.nbData * 4 + h.nbVar * 17) / 8 + 16);
+    appendSection(buf, &h, 1);
+    appendSection(buf, kind.data(), h.nbNode);
+    appendSection(buf, firstArc.data(), h.nbNode + 1);
+    appendSection(buf, child.data(), h.nbArc);
+    appendSection(buf, firstData.data(), h.nbArc + 1);
+    appendSection(buf, data.data(), h.nbData);
+    appendSection(buf, (double *) weights, 2 * h.nbVar);
+    appendSection(buf, proj.data(), h.nbVar);
+  }// freeze
+};
+
+
+/**
+   A binary decision-DNNF mapped in memory (read only), or built in
+   memory from a compiled DAG (freeze): the sections are used in place.
+ */
+class BinaryNNFMapping
+{
+  void *base;
+  size_t length;
+  std::vector<uint64_t> frozen;  // the sections when they are built in memory (not mapped)
+
+  template<class E> bool section(const char *&p, const E *&data, uint64_t nb)
+  {
+    uint64_t sz = (nb * sizeof(E) + 7) & ~(uint64_t) 7;
+    if(nb > length || (uint64_t) ((const char *) base + length - p) < sz) return false;
+    data = (const E *) p;
+    p += sz;
+    return true;
+  }// section
+
+public:
+  const BinaryNNFHeader *header;
+  const uint8_t *kind, *projected;
+  const uint64_t *firstArc, *firstData;
+  const uint32_t *child;
+  const int32_t *data;
+  const double *weights;
+
+  BinaryNNFMapping() : base(NULL), length(0), header(NULL) {}
+  ~BinaryNNFMapping(){if(base && base != (void *) frozen.data()) munmap(base, length);}
+
+  /**
+     Map a file written by BinaryNNFWriter and check its structure.
+
+     \return false if the file cannot be read or is not a valid binary d-DNNF
+   */
+  bool load(const char *fileName)
+  {
+    int fd = open(fileName, O_RDONLY);
+    if(fd < 0) return false;
+
+    bool ok = load(fd);
+    close(fd);
+    return ok;
+  }// load
+
+  /**
+     Same as above on an open file, from its beginning (the mapping
+     stays valid once fd is closed).
+   */
+  bool load(int fd)
+  {
+    struct stat st;
+    if(fstat(fd, &st) || st.st_size < (off_t) sizeof(BinaryNNFHeader)) return false;
+    length = st.st_size;
+    base = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(base == MAP_FAILED){base = NULL; return false;}
+    return check();
+  }// load
+
+  /**
+     Take the representation built by a writer, kept in memory: the
+     compiled DAG is then evaluated with the loops of BinaryNNF instead
+     of the virtual calls on its nodes.
+
+     \return false if the representation is not valid (it should not happen)
+   */
+  bool freeze(BinaryNNFWriter &w, vec<double> &weights, vec<bool> &projected)
+  {
+    w.freeze(frozen, weights, projected);
+    base = frozen.data();
+    length = frozen.size() * sizeof(uint64_t);
+    return check();
+  }// freeze
+
+  /**
+     Set the sections and check the structure of the representation.
+   */
+  bool check()
+  {
+    const char *p = (const char *) base;
+    if(!section(p, header, 1)) return false;
+    if(memcmp(header->magic, BINARY_NNF_MAGIC, sizeof(header->magic)) || header->version != BINARY_NNF_VERSION || !header->nbNode) return false;
+
+    if(!section(p, kind, header->nbNode) || !section(p, firstArc, header->nbNode + 1) ||
+       !section(p, child, header->nbArc) ||
+       !section(p, firstData, header->nbArc + 1) || !section(p, data, header->nbData) ||
+       !section(p, weights, 2 * (uint64_t) header->nbVar) || !section(p, projected, header->nbVar)) return false;
+
+    // the evaluation relies on the order of the nodes and on the bounds
+    if(firstArc[header->nbNode] != header->nbArc || firstData[header->nbArc] != header->nbData) return false;
+    for(uint64_t i = 0 ; i<header->nbNode ; i++)
+      {
+        if(firstArc[i] > firstArc[i + 1]) return false;
+        for(uint64_t j = firstArc[i] ; j<firstArc[i + 1] ; j++) if(child[j] >= i) return false;
+      }
+    for(uint64_t i = 0 ; i<header->nbArc ; i++)
+      {
+        if(firstData[i] > firstData[i + 1]) return false;
+
+        bool isFree = false;
+        for(uint64_t j = firstData[i] ; j<firstData[i + 1] ; j++)
+          {
+            if(!data[j] && !isFree){isFree = true; continue;}
+            if(!data[j] || (uint32_t) abs(data[j]) > header->nbVar || (isFree && data[j] < 0)) return false;
+          }
+      }
+
+    return true;
+  }// check
+
+  inline uint64_t getRoot(){return header->nbNode - 1;}
+
+  inline bool hasIntegerWeights()
+  {
+    double e;
+    for(uint64_t i = 0 ; i<2 * (uint64_t) header->nbVar ; i++) if(modf(weights[i], &e) != 0.0) return false;
+    return true;
+  }// hasIntegerWeights
+};
+
+
+/**
+   What the incremental evaluation of the queries needs, built once and
+   shared (read only) by the evaluators of all the threads: the parents
+   of each node, the nodes having an arc on each projected variable and
+   the value of each node when nothing is fixed.
+ */
+template<class T> struct BinaryNNFIndex
+{
+  std::vector<uint64_t> firstParent, firstOcc;
+  std::vector<uint32_t> parent, occ;
+  std::vector<T> base;
+};
+
+
+/**
+   The queries of DAG (model counting and satisfiability under a set
+   of literals) on a mapped binary decision-DNNF.
+
+   With an index (see buildIndex), a count only evaluates again the
+   nodes above an arc on a fixed variable, the other ones keep their
+   value without conditioning. The satisfiability is decided for up to
+   64 queries in one pass, one bit per query.
+ */
+template<class T> class BinaryNNF
+{
+  BinaryNNFMapping &m;
+  vec<char> fixedValue;  // 0, or 1 + sign of the literal fixed by the query
+  std::vector<T> values;
+  std::vector<char> sat;
+
+  // the weight of each literal (toInt) then of each free variable (2 * nbVar + v)
+  std::vector<T> weight;
+  std::vector<char> isOne;
+  T tmp;
+
+  const BinaryNNFIndex<T> *index;
+  std::vector<uint32_t> stamp, affected;
+  uint32_t stampIdx;
+  std::vector<uint64_t> falsified, satMask; // one bit per query of the batch
+
+  inline Var varOf(int32_t l){return abs(l) - 1;}
+  inline int idxOf(int32_t l){return toInt(readableLitToLit(l));}
+
+  inline bool conflict(int32_t l)
+  {
+    char f = fixedValue[varOf(l)];
+    return f && f != (l < 0) + 1;
+  }// conflict
+
+  /**
+     Multiply w by the weight of the unit literals and the free
+     variables of an arc, as Branch::computeNbModels (the weights equal
+     to 1 are skipped).
+
+     \return false if a unit literal is in conflict with the query (w is not modified)
+   */
+  inline bool weightArc(uint64_t a, T &w)
+  {
+    uint64_t i = m.firstData[a];
+    for(uint64_t j = i ; j<m.firstData[a + 1] && m.data[j] ; j++)
+      if(m.projected[varOf(m.data[j])] && conflict(m.data[j])) return false;
+
+    for( ; i<m.firstData[a + 1] && m.data[i] ; i++)
+      {
+        int32_t l = m.data[i];
+        if(m.projected[varOf(l)] && !isOne[idxOf(l)]) w *= weight[idxOf(l)];
+      }
+
+    for(i++ ; i<m.firstData[a + 1] ; i++)
+      {
+        Var v = m.data[i] - 1;
+        if(!m.projected[v]) continue;
+        int idx = fixedValue[v] ? (v << 1) | (fixedValue[v] - 1) : (int) (2 * m.header->nbVar + v);
+        if(!isOne[idx]) w *= weight[idx];
+      }
+    return true;
+  }// weightArc
+
+  inline const T &valueOf(uint32_t i){return (index && stamp[i] != stampIdx) ? index->base[i] : values[i];}
+
+  inline void evaluate(uint64_t i)
+  {
+    T &v = values[i];
+    switch(m.kind[i])
+      {
+      case 't' : v = 1; break;
+      case 'f' : v = 0; break;
+      case 'a' :
+        v = 1;
+        for(uint64_t a = m.firstArc[i] ; a<m.firstArc[i + 1] ; a++)
+          {
+            const T &c = valueOf(m.child[a]);
+            if(c == 0 || !weightArc(a, v)){v = 0; break;}
+            v *= c;
+          }
+        break;
+      default :
+        v = 0;
+        for(uint64_t a = m.firstArc[i] ; a<m.firstArc[i + 1] ; a++)
+          {
+            const T &c = valueOf(m.child[a]);
+            if(c == 0) continue;
+            tmp = c;
+            if(weightArc(a, tmp)) v += tmp;
+          }
+      }
+  }// evaluate
+
+  inline void mark(uint32_t i)
+  {
+    if(stamp[i] == stampIdx) return;
+    stamp[i] = stampIdx;
+    affected.push_back(i);
+  }// mark
+
+  /**
+     Evaluate the nodes which depend on the fixed variables (the other
+     ones have the value given by the index).
+   */
+  template<class Q> T computeNbModelsIncremental(const Q &v)
+  {
+    if(!++stampIdx){std::fill(stamp.begin(), stamp.end(), 0); stampIdx = 1;}
+    affected.clear();
+
+    for(int i = 0 ; i<(int) v.size() ; i++)
+      {
+        Var x = var(v[i]);
+        for(uint64_t j = index->firstOcc[x] ; j<index->firstOcc[x + 1] ; j++) mark(index->occ[j]);
+      }
+
+    for(size_t k = 0 ; k<affected.size() ; k++)
+      {
+        uint32_t i = affected[k];
+        for(uint64_t j = index->firstParent[i] ; j<index->firstParent[i + 1] ; j++) mark(index->parent[j]);
+      }
+
+    std::sort(affected.begin(), affected.end());
+    for(size_t k = 0 ; k<affected.size() ; k++) evaluate(affected[k]);
+    return valueOf(m.getRoot());
+  }// computeNbModelsIncremental
+
+public:
+  BinaryNNF(BinaryNNFMapping &_m) : m(_m), fixedValue(_m.header->nbVar, 0), index(NULL), stampIdx(0)
+  {
+    uint64_t nbVar = m.header->nbVar;
+    for(uint64_t i = 0 ; i<3 * nbVar ; i++)
+      {
+        double w = (i < 2 * nbVar) ? m.weights[i] : m.weights[2 * (i - 2 * nbVar)] + m.weights[2 * (i - 2 * nbVar) + 1];
+        weight.push_back(T(w));
+        isOne.push_back(w == 1);
+      }
+  }// constructor
+
+  /**
+     Compute the index used to answer the queries incrementally, the
+     evaluators then share it with setIndex.
+   */
+  void buildIndex(BinaryNNFIndex<T> &idx)
+  {
+    const BinaryNNFIndex<T> *save = index;
+    index = NULL;
+    computeNbModels();
+    idx.base.swap(values);
+    index = save;
+
+    uint64_t nbNode = m.header->nbNode, nbVar = m.header->nbVar;
+    idx.firstParent.assign(nbNode + 1, 0);
+    for(uint64_t a = 0 ; a<m.header->nbArc ; a++) idx.firstParent[m.child[a] + 1]++;
+    for(uint64_t i = 0 ; i<nbNode ; i++) idx.firstParent[i + 1] += idx.firstParent[i];
+
+    std::vector<uint64_t> pos(idx.firstParent.begin(), idx.firstParent.end() - 1);
+    idx.parent.resize(m.header->nbArc);
+    for(uint64_t i = 0 ; i<nbNode ; i++)
+      for(uint64_t a = m.firstArc[i] ; a<m.firstArc[i + 1] ; a++) idx.parent[pos[m.child[a]]++] = i;
+
+    // each node is given once for each projected variable of its arcs
+    std::vector<int64_t> last(nbVar, -1);
+    idx.firstOcc.assign(nbVar + 1, 0);
+    for(int pass = 0 ; pass<2 ; pass++)
+      {
+        if(pass)
+          {
+            for(uint64_t x = 0 ; x<nbVar ; x++) idx.firstOcc[x + 1] += idx.firstOcc[x];
+            pos.assign(idx.firstOcc.begin(), idx.firstOcc.end() - 1);
+            idx.occ.resize(idx.firstOcc[nbVar]);
+            std::fill(last.begin(), last.end(), -1);
+          }
+
+        for(uint64_t i = 0 ; i<nbNode ; i++)
+          for(uint64_t j = m.firstData[m.firstArc[i]] ; j<m.firstData[m.firstArc[i + 1]] ; j++)
+            {
+              if(!m.data[j]) continue;
+              Var x = varOf(m.data[j]);
+              if(!m.projected[x] || last[x] == (int64_t) i) continue;
+              last[x] = i;
+              if(pass) idx.occ[pos[x]++] = i;
+              else idx.firstOcc[x + 1]++;
+            }
+      }
+  }// buildIndex
+
+  /**
+     Weighted count of the formula conditioned by each literal, for all
+     of them in one upward and one downward pass. Every model gives a
+     weight to each projected variable, then the count conditioned by l
+     is w(l) times the derivative of the circuit with respect to w(l).
+     The derivatives of the products are computed with prefix and suffix
+     products (no division, a weight can be 0).
+
+     With projected variables, a path of the d-DNNF does not give a
+     weight to each projected variable: the literals are then
+     conditioned one at a time, incrementally, as the queries.
+
+     @param[out] res, the count conditioned by each literal (toInt)
+     \return the count without conditioning
+   */
+  T computeMarginals(std::vector<T> &res)
+  {
+    const BinaryNNFIndex<T> *save = index;
+    index = NULL;
+    T total = computeNbModels();
+    index = save;
+
+    uint64_t nbNode = m.header->nbNode, nbVar = m.header->nbVar;
+    bool hasHidden = false; // a variable is not projected
+    for(uint64_t v = 0 ; v<nbVar ; v++) hasHidden = hasHidden || !m.projected[v];
+    if(hasHidden)
+      {
+        BinaryNNFIndex<T> idx;
+        buildIndex(idx);
+        setIndex(&idx);
+
+        vec<Lit> lit(1);
+        res.resize(2 * nbVar);
+        for(uint64_t r = 0 ; r<2 * nbVar ; r++)
+          {
+            lit[0] = toLit(r);
+            res[r] = computeNbModelsConditioning(lit);
+          }
+
+        setIndex(save);
+        return total;
+      }
+
+    std::vector<T> derivative(nbNode), dLit(2 * nbVar), arcValue, arcDerivative, factor, prefix, suffix;
+    std::vector<uint64_t> rows;
+    derivative[m.getRoot()] = 1;
+
+    for(uint64_t i = nbNode ; i-- > 0 ; )
+      {
+        uint64_t first = m.firstArc[i], nb = m.firstArc[i + 1] - first;
+        if(derivative[i] == 0 || !nb) continue;
+
+        arcDerivative.assign(nb, derivative[i]);
+        if(m.kind[i] == 'a')
+          {
+            // the derivative with respect to an arc is the product of the other ones
+            arcValue.resize(nb);
+            for(uint64_t a = 0 ; a<nb ; a++)
+              {
+                arcValue[a] = values[m.child[first + a]];
+                weightArc(first + a, arcValue[a]);
+              }
+
+            suffix.resize(nb + 1);
+            suffix[nb] = 1;
+            for(uint64_t a = nb ; a-- > 0 ; ) suffix[a] = suffix[a + 1] * arcValue[a];
+            T pre = 1;
+            for(uint64_t a = 0 ; a<nb ; a++)
+              {
+                arcDerivative[a] *= pre * suffix[a + 1];
+                pre *= arcValue[a];
+              }
+          }
+
+        // an arc is the product of its child and of the weights of its projected literals
+        for(uint64_t a = 0 ; a<nb ; a++)
+          {
+            if(arcDerivative[a] == 0) continue;
+
+            uint64_t arc = first + a;
+            factor.clear();
+            rows.clear();
+            factor.push_back(values[m.child[arc]]);
+            bool isFree = false;
+            for(uint64_t j = m.firstData[arc] ; j<m.firstData[arc + 1] ; j++)
+              {
+                if(!m.data[j]){isFree = true; continue;}
+                if(!m.projected[varOf(m.data[j])]) continue;
+                rows.push_back(isFree ? 2 * nbVar + m.data[j] - 1 : idxOf(m.data[j]));
+                factor.push_back(weight[rows.back()]);
+              }
+
+            uint64_t nbFactor = factor.size();
+            prefix.resize(nbFactor + 1);
+            suffix.resize(nbFactor + 1);
+            prefix[0] = 1;
+            suffix[nbFactor] = 1;
+            for(uint64_t j = 0 ; j<nbFactor ; j++) prefix[j + 1] = prefix[j] * factor[j];
+            for(uint64_t j = nbFactor ; j-- > 0 ; ) suffix[j] = suffix[j + 1] * factor[j];
+
+            derivative[m.child[arc]] += arcDerivative[a] * suffix[1];
+            for(uint64_t j = 1 ; j<nbFactor ; j++)
+              {
+                T d = arcDerivative[a] * prefix[j] * suffix[j + 1];
+                uint64_t r = rows[j - 1];
+                if(r < 2 * nbVar) dLit[r] += d;
+                else
+                  {
+                    // d(w(v) + w(~v)) / dw(l) = 1 for both literals of v
+                    dLit[2 * (r - 2 * nbVar)] += d;
+                    dLit[2 * (r - 2 * nbVar) + 1] += d;
+                  }
+              }
+          }
+      }
+
+    res.resize(2 * nbVar);
+    for(uint64_t r = 0 ; r<2 * nbVar ; r++) res[r] = weight[r] * dLit[r];
+    return total;
+  }// computeMarginals
+
+  inline void setIndex(const BinaryNNFIndex<T> *idx)
+  {
+    index = idx;
+    stamp.assign(m.header->nbNode, 0);
+    stampIdx = 0;
+  }// setIndex
+
+  T computeNbModels()
+  {
+    values.resize(m.header->nbNode);
+    if(index)
+      {
+        vec<Lit> none;
+        return computeNbModelsIncremental(none);
+      }
+
+    for(uint64_t i = 0 ; i<m.header->nbNode ; i++) evaluate(i);
+    return values[m.getRoot()];
+  }// computeNbModels
+
+  bool isSAT()
+  {
+    sat.resize(m.header->nbNode);
+    for(uint64_t i = 0 ; i<m.header->nbNode ; i++)
+      {
+        bool isAnd = m.kind[i] == 'a', res = m.kind[i] != 'f' && (isAnd || m.kind[i] == 't');
+        for(uint64_t a = m.firstArc[i] ; a<m.firstArc[i + 1] && res == isAnd ; a++)
+          {
+            bool arc = sat[m.child[a]];
+            for(uint64_t j = m.firstData[a] ; arc && j<m.firstData[a + 1] && m.data[j] ; j++) arc = !conflict(m.data[j]);
+            res = arc;
+          }
+        sat[i] = res;
+      }
+    return sat[m.getRoot()];
+  }// isSAT
+
+  template<class Q> inline T computeNbModelsConditioning(const Q &v)
+  {
+    for(int i = 0 ; i<(int) v.size() ; i++) fixedValue[var(v[i])] = sign(v[i]) + 1;
+    values.resize(m.header->nbNode);
+    T tmp = index ? computeNbModelsIncremental(v) : computeNbModels();
+    for(int i = 0 ; i<(int) v.size() ; i++) fixedValue[var(v[i])] = 0;
+    return tmp;
+  }// computeNbModelsConditioning
+
+  template<class Q> inline bool isSATConditioning(const Q &v)
+  {
+    for(int i = 0 ; i<(int) v.size() ; i++) fixedValue[var(v[i])] = sign(v[i]) + 1;
+    bool tmp = isSAT();
+    for(int i = 0 ; i<(int) v.size() ; i++) fixedValue[var(v[i])] = 0;
+    return tmp;
+  }// isSATConditioning
+
+  /**
+     Satisfiability of several queries in one pass on the nodes: bit q
+     of the mask of a node is set if it is satisfiable under queries[q].
+
+     @param[in] queries, the queries (at most 64)
+     @param[in] nb, the number of queries
+     @param[out] res, the answer for each query
+   */
+  template<class Q> void isSATConditioning(Q * const *queries, int nb, bool *res)
+  {
+    assert(nb > 0 && nb <= 64);
+    uint64_t all = (nb == 64) ? ~(uint64_t) 0 : ((uint64_t) 1 << nb) - 1;
+
+    falsified.resize(2 * (uint64_t) m.header->nbVar, 0);
+    for(int q = 0 ; q<nb ; q++)
+      for(int i = 0 ; i<(int) queries[q]->size() ; i++) falsified[toInt(~(*queries[q])[i])] |= (uint64_t) 1 << q;
+
+    satMask.resize(m.header->nbNode);
+    for(uint64_t i = 0 ; i<m.header->nbNode ; i++)
+      {
+        bool isAnd = m.kind[i] == 'a';
+        uint64_t res = (m.kind[i] == 't' || isAnd) ? all : 0;
+        for(uint64_t a = m.firstArc[i] ; a<m.firstArc[i + 1] && res != (isAnd ? 0 : all) ; a++)
+          {
+            uint64_t arc = satMask[m.child[a]];
+            for(uint64_t j = m.firstData[a] ; arc && j<m.firstData[a + 1] && m.data[j] ; j++)
+              arc &= ~falsified[idxOf(m.data[j])];
+            if(isAnd) res &= arc; else res |= arc;
+          }
+        satMask[i] = res;
+      }
+
+    for(int q = 0 ; q<nb ; q++) res[q] = (satMask[m.getRoot()] >> q) & 1;
+    for(int q = 0 ; q<nb ; q++)
+      for(int i = 0 ; i<(int) queries[q]->size() ; i++) falsified[toInt(~(*queries[q])[i])] = 0;
+  }// isSATConditioning
+};
+
+
+/**
+   Approximate model counting of up to BINARY_NNF_LANES queries in one
+   pass on the nodes, with one lane of doubles per query. The loops on
+   the lanes have a fixed length, so the compiler vectorizes them. In
+   log mode the lanes hold natural logarithms, which do not overflow
+   when the count goes beyond 1e308.
+
+   The weights of the literals are kept in one row of lanes per literal
+   and per free variable: a query only changes the rows of its
+   variables (the weight of the negation of a fixed literal is 0 in its
+   lane), then an arc is the product of its child and of its rows.
+ */
+class BinaryNNFLanes
+{
+  BinaryNNFMapping &m;
+  bool logMode;
+  std::vector<double> values;  // BINARY_NNF_LANES per node
+  std::vector<double> weight;  // BINARY_NNF_LANES per literal (toInt) then per free variable (2 * nbVar + v)
+  std::vector<double> base;    // the weight of each row without any query
+  std::vector<double> arcs;    // the lanes of the arcs of an OR node (log mode)
+
+  inline int idxOf(int32_t l){return toInt(readableLitToLit(l));}
+  inline double *row(uint64_t r){return &weight[r * BINARY_NNF_LANES];}
+  inline double toLane(double w){return logMode ? log(w) : w;}
+
+  /**
+     The lanes of an arc: the value of its child times the weight of
+     its unit literals and its free variables.
+   */
+  inline void evaluateArc(uint64_t a, double *res)
+  {
+    double r[BINARY_NNF_LANES]; // local, then not aliased with the rows
+    const double *c = &values[(uint64_t) m.child[a] * BINARY_NNF_LANES];
+    for(int k = 0 ; k<BINARY_NNF_LANES ; k++) r[k] = c[k];
+
+    uint64_t nbVar = m.header->nbVar;
+    bool isFree = false;
+    for(uint64_t j = m.firstData[a] ; j<m.firstData[a + 1] ; j++)
+      {
+        if(!m.data[j]){isFree = true; continue;}
+        const double *w = row(isFree ? 2 * nbVar + m.data[j] - 1 : idxOf(m.data[j]));
+        if(logMode) for(int k = 0 ; k<BINARY_NNF_LANES ; k++) r[k] += w[k];
+        else for(int k = 0 ; k<BINARY_NNF_LANES ; k++) r[k] *= w[k];
+      }
+    for(int k = 0 ; k<BINARY_NNF_LANES ; k++) res[k] = r[k];
+  }// evaluateArc
+
+  void evaluate(uint64_t i)
+  {
+    double *v = &values[i * BINARY_NNF_LANES], tmp[BINARY_NNF_LANES];
+    const double zero = logMode ? -HUGE_VAL : 0, one = logMode ? 0 : 1;
+
+    if(m.kind[i] == 't' || m.kind[i] == 'f')
+      {
+        for(int k = 0 ; k<BINARY_NNF_LANES ; k++) v[k] = (m.kind[i] == 't') ? one : zero;
+      }
+    else if(m.kind[i] == 'a')
+      {
+        for(int k = 0 ; k<BINARY_NNF_LANES ; k++) v[k] = one;
+        for(uint64_t a = m.firstArc[i] ; a<m.firstArc[i + 1] ; a++)
+          {
+            evaluateArc(a, tmp);
+            if(logMode) for(int k = 0 ; k<BINARY_NNF_LANES ; k++) v[k] += tmp[k];
+            else for(int k = 0 ; k<BINARY_NNF_LANES ; k++) v[k] *= tmp[k];
+          }
+      }
+    else if(!logMode)
+      {
+        for(int k = 0 ; k<BINARY_NNF_LANES ; k++) v[k] = 0;
+        for(uint64_t a = m.firstArc[i] ; a<m.firstArc[i + 1] ; a++)
+          {
+            evaluateArc(a, tmp);
+            for(int k = 0 ; k<BINARY_NNF_LANES ; k++) v[k] += tmp[k];
+          }
+      }
+    else
+      {
+        // log(sum exp(x)) = max + log(sum exp(x - max))
+        uint64_t nb = m.firstArc[i + 1] - m.firstArc[i];
+        arcs.resize(nb * BINARY_NNF_LANES);
+        for(int k = 0 ; k<BINARY_NNF_LANES ; k++) v[k] = -HUGE_VAL;
+        for(uint64_t a = 0 ; a<nb ; a++)
+          {
+            double *x = &arcs[a * BINARY_NNF_LANES];
+            evaluateArc(m.firstArc[i] + a, x);
+            for(int k = 0 ; k<BINARY_NNF_LANES ; k++) v[k] = std::max(v[k], x[k]);
+          }
+
+        for(int k = 0 ; k<BINARY_NNF_LANES ; k++) tmp[k] = 0;
+        for(uint64_t a = 0 ; a<nb ; a++)
+          {
+            double *x = &arcs[a * BINARY_NNF_LANES];
+            for(int k = 0 ; k<BINARY_NNF_LANES ; k++) tmp[k] += exp(x[k] - v[k]);
+          }
+        for(int k = 0 ; k<BINARY_NNF_LANES ; k++) if(v[k] != -HUGE_VAL) v[k] += log(tmp[k]);
+      }
+  }// evaluate
+
+  /**
+     Fix (or release) the literals of a query in its lane.
+   */
+  template<class Q> void setQuery(const Q &q, int k, bool release)
+  {
+    uint64_t nbVar = m.header->nbVar;
+    for(int i = 0 ; i<(int) q.size() ; i++)
+      {
+        Var v = var(q[i]);
+        if(!m.projected[v]) continue;
+        uint64_t neg = toInt(~q[i]), fr = 2 * nbVar + v;
+        row(neg)[k] = release ? base[neg] : toLane(0);
+        row(fr)[k] = release ? base[fr] : toLane(m.weights[toInt(q[i])]);
+      }
+  }// setQuery
+
+public:
+  BinaryNNFLanes(BinaryNNFMapping &_m, bool _logMode) : m(_m), logMode(_logMode)
+  {
+    uint64_t nbVar = m.header->nbVar;
+    for(uint64_t r = 0 ; r<3 * nbVar ; r++)
+      {
+        Var v = (r < 2 * nbVar) ? r >> 1 : r - 2 * nbVar;
+        double w = 1;
+        if(m.projected[v]) w = (r < 2 * nbVar) ? m.weights[r] : m.weights[2 * v] + m.weights[2 * v + 1];
+        base.push_back(toLane(w));
+      }
+
+    weight.resize(base.size() * BINARY_NNF_LANES);
+    for(uint64_t r = 0 ; r<base.size() ; r++)
+      for(int k = 0 ; k<BINARY_NNF_LANES ; k++) row(r)[k] = base[r];
+  }// constructor
+
+  /**
+     Count the models of each query (a query with a literal and its
+     negation is not expected).
+
+     @param[in] queries, the queries (at most BINARY_NNF_LANES)
+     @param[in] nb, the number of queries
+     @param[out] res, the count (or its natural logarithm in log mode) for each query
+   */
+  template<class Q> void computeNbModelsConditioning(Q * const *queries, int nb, double *res)
+  {
+    assert(nb > 0 && nb <= BINARY_NNF_LANES);
+    for(int k = 0 ; k<nb ; k++) setQuery(*queries[k], k, false);
+
+    values.resize(m.header->nbNode * BINARY_NNF_LANES);
+    for(uint64_t i = 0 ; i<m.header->nbNode ; i++) evaluate(i);
+    for(int k = 0 ; k<nb ; k++) res[k] = values[m.getRoot() * BINARY_NNF_LANES + k];
+
+    for(int k = 0 ; k<nb ; k++) setQuery(*queries[k], k, true);
+  }// computeNbModelsConditioning
+};
+
+#endif
@@ -68,6 +68,11 @@ public:
     d->printNNF(out, certif);
   }// printNNF
 
+  inline void addArc(BinaryNNFWriter &w, unsigned idxChild)
+  {
+    w.addArc(idxChild, &DAG<T>::unitLits[idxUnitLit], &DAG<T>::freeVariables[idxFreeVar]);
+  }// addArc
+
   inline int computeState_(int nbAssums)
   {
     Lit *pUnit = &DAG<T>::unitLits[idxUnitLit];
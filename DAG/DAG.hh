@@ -46,6 +46,7 @@
 #define TOUCH 1
 #define TOUCH_UNSAT 2
 
+#include "BinaryNNF.hh"
 #include "Branch.hh"
 #include "ImplicitAnd.hh"
 #include "Root.hh"
@@ -100,6 +101,19 @@ template<class T> class DAG
   }
 
   virtual void printNNF(std::ostream& out, bool certif) = 0;
+
+  /**
+     Add the node, after the nodes below it, to the binary
+     representation (see BinaryNNF.hh). As for printNNF, the stamp gives
+     the index of the nodes already added.
+
+     \return the index of the node
+  */
+  virtual unsigned writeBinaryNNF(BinaryNNFWriter &w){assert(0); return 0;}
+  inline bool isWritten(){return stamp >= globalStamp;}
+  inline unsigned getWrittenIdx(){return stamp - globalStamp;}
+  inline unsigned setWrittenIdx(unsigned idx){stamp = globalStamp + idx; return idx;}
+
   virtual T computeNbModels();
   virtual void debug(){}
   virtual void debug(vec<Lit> &trail){}
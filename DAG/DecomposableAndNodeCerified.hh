@@ -106,6 +106,19 @@ public:
       }
   }// printNNF
 
+  inline unsigned writeBinaryNNF(BinaryNNFWriter &w)
+  {
+    if(this->isWritten()) return this->getWrittenIdx();
+
+    vec<unsigned> idxChildren;
+    DAG<T> **children = &allChildren[header.posInAllChildren];
+    for(int i = 0 ; i<header.szChildren ; i++) idxChildren.push(children[i]->writeBinaryNNF(w));
+
+    unsigned idxCurrent = w.addNode('a');
+    for(int i = 0 ; i<idxChildren.size() ; i++) w.addArc(idxChildren[i], NULL, NULL);
+    return this->setWrittenIdx(idxCurrent);
+  }// writeBinaryNNF
+
 
   inline bool isSAT(vec<Lit> &unitsLitBranches)
   {
@@ -38,6 +38,12 @@ public:
     out << "f " << idxCurrent << " 0" << endl;
   }
 
+  inline unsigned writeBinaryNNF(BinaryNNFWriter &w)
+  {
+    if(this->isWritten()) return this->getWrittenIdx();
+    return this->setWrittenIdx(w.addNode('f'));
+  }
+
   inline bool isSAT(vec<Lit> &unitsLitBranches) {return false;}
   inline T computeNbModels() { return 0; }
 };
@@ -94,6 +94,19 @@ public:
   }// printNNF
 
 
+  inline unsigned writeBinaryNNF(BinaryNNFWriter &w)
+  {
+    globalStamp++; // forget the stamps of the previous traversals
+
+    unsigned idxChild = (b.d)->writeBinaryNNF(w);
+    unsigned idxCurrent = w.addNode('o');
+    b.addArc(w, idxChild);
+
+    globalStamp += w.getNbNode();
+    return idxCurrent;
+  }// writeBinaryNNF
+
+
   inline bool isSAT()
   {
     globalStamp++;
@@ -37,6 +37,12 @@ public:
     out << "t " << idxCurrent << " 0" << endl;
   }
 
+  inline unsigned writeBinaryNNF(BinaryNNFWriter &w)
+  {
+    if(this->isWritten()) return this->getWrittenIdx();
+    return this->setWrittenIdx(w.addNode('t'));
+  }
+
   inline bool isSAT(vec<Lit> &unitsLitBranches){return true;}
   inline T computeNbModels() { return 1; }
 };
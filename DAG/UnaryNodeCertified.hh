@@ -76,6 +76,16 @@ public:
     out << "0" << endl;
   }// printNNF
 
+  inline unsigned writeBinaryNNF(BinaryNNFWriter &w)
+  {
+    if(this->isWritten()) return this->getWrittenIdx();
+
+    unsigned idxChild = (branch.d)->writeBinaryNNF(w);
+    unsigned idxCurrent = w.addNode('o');
+    branch.addArc(w, idxChild);
+    return this->setWrittenIdx(idxCurrent);
+  }// writeBinaryNNF
+
 
   inline bool isSAT()
   {
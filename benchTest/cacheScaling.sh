@@ -0,0 +1,22 @@
+#!/bin/bash
+# Hit rate and lock contention of the shared cache w.r.t. the number of threads.
+# usage: ./cacheScaling.sh instance.cnf [d4 options] (the binary is ../d4 or $D4)
+
+D4=${D4:-$(dirname $0)/../d4}
+INSTANCE=$1; shift
+
+printf "%8s %12s %12s %10s %12s %12s %10s\n" "#threads" "#posHit" "#negHit" "hitRate" "#contention" "#duplicate" "time(s)"
+for t in 1 2 4 8 16 32 64
+do
+  start=$(date +%s.%N)
+  out=$($D4 $INSTANCE -mc -threads=$t "$@" 2>&1)
+  end=$(date +%s.%N)
+
+  pos=$(echo "$out" | grep "Number of positive hit" | awk '{print $NF}')
+  neg=$(echo "$out" | grep "Number of negative hit" | awk '{print $NF}')
+  cont=$(echo "$out" | grep "Number of contended shard locks" | awk '{print $NF}')
+  dup=$(echo "$out" | grep "Number of entries already inserted" | awk '{print $NF}')
+  rate=$(echo "$pos $neg" | awk '{if($1 + $2) printf "%.2f%%", 100 * $1 / ($1 + $2); else print "-"}')
+
+  printf "%8d %12s %12s %10s %12s %12s %10.2f\n" $t $pos $neg $rate ${cont:-0} ${dup:-0} $(awk "BEGIN{print $end - $start}")
+done
@@ -0,0 +1,33 @@
+#!/bin/bash
+# Time of the count and of conditioned queries on the compiled DAG (virtual calls on the nodes)
+# against the flattened d-DNNF (-freeze).
+# usage: ./evaluation.sh [nbQuery] [instance.cnf ...] (all the CNF of benchTest by default, the binary is ../d4 or $D4)
+
+DIR=$(dirname $0)
+D4=${D4:-$DIR/../d4}
+NBQUERY=${1:-100}; shift
+INSTANCES=${@:-$DIR/*.cnf}
+TMP=$(mktemp -d)
+
+printf "%-24s %10s %10s %12s %10s %12s %10s\n" "instance" "#nodes" "freeze(s)" "count(s)" "frozen(s)" "queries(s)" "frozen(s)"
+for f in $INSTANCES
+do
+  # random queries of 1 to 4 literals on the variables of the instance
+  awk -v nb=$NBQUERY 'BEGIN{srand(1)} /^p/{n = $3} END{for(i = 0 ; i<nb ; i++){printf "m"; k = 1 + int(rand() * 4);
+    for(j = 0 ; j<k ; j++) printf " %d", (rand() < 0.5 ? -1 : 1) * (1 + int(rand() * n)); print " 0"}}' $f > $TMP/queries
+
+  dag=$($D4 $f -dDNNF 2>&1)
+  frozen=$($D4 $f -dDNNF -freeze 2>&1)
+  dagQuery=$($D4 $f -dDNNF -query < $TMP/queries 2>&1)
+  frozenQuery=$($D4 $f -dDNNF -freeze -query < $TMP/queries 2>&1)
+
+  printf "%-24s %10s %10s %12s %10s %12s %10s\n" $(basename $f) \
+         $(echo "$frozen" | grep "Frozen d-DNNF" | awk '{print $4}') \
+         $(echo "$frozen" | grep "Frozen d-DNNF" | awk '{print $(NF-1)}') \
+         $(echo "$dag" | grep "Count computed" | awk '{print $(NF-1)}') \
+         $(echo "$frozen" | grep "Count computed" | awk '{print $(NF-1)}') \
+         $(echo "$dagQuery" | grep "queries computed" | awk '{print $(NF-1)}') \
+         $(echo "$frozenQuery" | grep "queries computed" | awk '{print $(NF-1)}')
+done
+
+rm -rf $TMP
@@ -0,0 +1,13 @@
+#!/bin/bash
+# Time the variants of the cache key comparison on the keys of an instance.
+# usage: ./keyCompare.sh instance.cnf [d4 options] (the binary is ../d4 or $D4)
+
+D4=${D4:-$(dirname $0)/../d4}
+INSTANCE=$1; shift
+TMP=$(mktemp -d)
+
+g++ -std=c++11 -O3 -o $TMP/keyCompare $(dirname $0)/micro/keyCompare.cc || exit 1
+$D4 $INSTANCE -mc -cache-save=$TMP/cache "$@" > /dev/null 2>&1
+$TMP/keyCompare $TMP/cache
+
+rm -rf $TMP
@@ -0,0 +1,138 @@
+/*
+* d4
+* Copyright (C) 2020  Univ. Artois & CNRS
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+   Compare the variants of KeyCompare on the keys of a cache file
+   written by d4 -cache-save (see ../keyCompare.sh). Each key is
+   compared with a copy of itself (a positive hit) and with a copy
+   where the last byte differs (a fingerprint collision, the worst
+   case).
+
+   usage: keyCompare cacheFile [nbRound]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+
+#include "../../hashing/KeyCompare.hh"
+#include "../../manager/CacheBucket.hh"
+#include "../../manager/PersistentCache.hh"
+
+struct Key
+{
+  unsigned len;
+  std::vector<char> a, same, diff;
+};
+
+
+/**
+   Read the keys of the cache file.
+ */
+static bool readKeys(const char *fileName, std::vector<Key> &keys)
+{
+  FILE *f = fopen(fileName, "rb");
+  if(!f) return false;
+
+  PersistentCacheHeader info;
+  if(fread(&info, sizeof(PersistentCacheHeader), 1, f) != 1) { fclose(f); return false; }
+
+  for(uint64_t i = 0 ; i<info.nbEntry ; i++)
+  {
+    DataInfo header;
+    uint32_t szData, szValue;
+    if(fread(&header, sizeof(DataInfo), 1, f) != 1 || fread(&szData, sizeof(uint32_t), 1, f) != 1 ||
+       fread(&szValue, sizeof(uint32_t), 1, f) != 1) break;
+
+    Key k;
+    k.len = szData;
+    k.a.resize(szData + 1);
+    if(fread(k.a.data(), 1, szData, f) != szData || fseek(f, szValue, SEEK_CUR)) break;
+    if(!szData) continue;
+
+    k.same = k.a;
+    k.diff = k.a;
+    k.diff[szData - 1] ^= 1;
+    keys.push_back(k);
+  }
+
+  fclose(f);
+  return true;
+}// readKeys
+
+
+/**
+   Run the given variant and return the number of ns per comparison.
+ */
+static double run(KeyCompare::EqualFunction f, std::vector<Key> &keys, bool same, int nbRound, unsigned &nbEqual)
+{
+  auto start = std::chrono::steady_clock::now();
+  for(int r = 0 ; r<nbRound ; r++)
+    for(size_t i = 0 ; i<keys.size() ; i++)
+      nbEqual += f(keys[i].a.data(), same ? keys[i].same.data() : keys[i].diff.data(), keys[i].len);
+  auto end = std::chrono::steady_clock::now();
+
+  return std::chrono::duration<double, std::nano>(end - start).count() / ((double) nbRound * keys.size());
+}// run
+
+
+int main(int argc, char **argv)
+{
+  if(argc < 2)
+  {
+    fprintf(stderr, "usage: %s cacheFile [nbRound]\n", argv[0]);
+    return 1;
+  }
+
+  std::vector<Key> keys;
+  if(!readKeys(argv[1], keys) || !keys.size())
+  {
+    fprintf(stderr, "cannot read the keys of %s\n", argv[1]);
+    return 1;
+  }
+  int nbRound = argc > 2 ? atoi(argv[2]) : 100;
+
+  double sumLen = 0;
+  unsigned maxLen = 0;
+  for(size_t i = 0 ; i<keys.size() ; i++)
+  {
+    sumLen += keys[i].len;
+    if(keys[i].len > maxLen) maxLen = keys[i].len;
+  }
+  printf("%lu keys, %.1f bytes on average, %u at most (selected variant: %s)\n", keys.size(),
+         sumLen / keys.size(), maxLen, KeyCompare::nameEqual(KeyCompare::selectEqual()));
+
+  std::vector<KeyCompare::EqualFunction> variants = {KeyCompare::equalMemcmp, KeyCompare::equalScalar};
+#ifdef KEY_COMPARE_X86
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("sse2")) variants.push_back(KeyCompare::equalSse2);
+  if(__builtin_cpu_supports("avx2")) variants.push_back(KeyCompare::equalAvx2);
+#endif
+
+  printf("%8s %14s %14s\n", "variant", "hit(ns/key)", "diff(ns/key)");
+  for(size_t v = 0 ; v<variants.size() ; v++)
+  {
+    unsigned nbEqual = 0;
+    double tSame = run(variants[v], keys, true, nbRound, nbEqual);
+    double tDiff = run(variants[v], keys, false, nbRound, nbEqual);
+    if(nbEqual != nbRound * keys.size()) printf("c WARNING! %s gives wrong answers\n", KeyCompare::nameEqual(variants[v]));
+    printf("%8s %14.2f %14.2f\n", KeyCompare::nameEqual(variants[v]), tSame, tDiff);
+  }
+
+  return 0;
+}
@@ -0,0 +1,116 @@
+/*
+* d4
+* Copyright (C) 2020  Univ. Artois & CNRS
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+   Throughput of DynamicOccurrenceManager::preUpdate/postUpdate (see
+   ../occurrenceUpdate.sh). Each round assigns random literals one at a
+   time, as the decisions of a branch, until half of the variables are
+   assigned, then unassigns them in the reverse order.
+
+   usage: occurrenceUpdate instance.cnf [nbRound] [seed]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <random>
+
+#include "../../manager/dynamicOccurrenceManager.hh"
+
+
+/**
+   Read the clauses of a DIMACS file (the other lines are skipped).
+ */
+static bool readCnf(const char *fileName, vec<vec<Lit> > &clauses, int &nbVar)
+{
+  FILE *f = fopen(fileName, "r");
+  if(!f) return false;
+
+  char line[1 << 16];
+  vec<Lit> cl;
+  nbVar = 0;
+  while(fgets(line, sizeof(line), f))
+  {
+    if(line[0] != '-' && (line[0] < '0' || line[0] > '9') && line[0] != ' ') continue;
+
+    for(char *p = line, *end ; ; p = end)
+    {
+      long v = strtol(p, &end, 10);
+      if(end == p) break;
+      if(!v){ if(cl.size()) clauses.push(); cl.copyTo(clauses.last()); cl.clear(); continue; }
+      if(abs(v) > nbVar) nbVar = abs(v);
+      cl.push(mkLit(abs(v) - 1, v < 0));
+    }
+  }
+
+  fclose(f);
+  return clauses.size() > 0;
+}// readCnf
+
+
+int main(int argc, char **argv)
+{
+  if(argc < 2)
+  {
+    fprintf(stderr, "usage: %s instance.cnf [nbRound] [seed]\n", argv[0]);
+    return 1;
+  }
+
+  vec<vec<Lit> > clauses;
+  int nbVar;
+  if(!readCnf(argv[1], clauses, nbVar))
+  {
+    fprintf(stderr, "cannot read the clauses of %s\n", argv[1]);
+    return 1;
+  }
+  int nbRound = argc > 2 ? atoi(argv[2]) : 1000;
+  std::mt19937 rng(argc > 3 ? atoi(argv[3]) : 0);
+
+  DynamicOccurrenceManager om(clauses, nbVar);
+  long int nbOccurrence = 0;
+  for(int i = 0 ; i<(nbVar << 1) ; i++) nbOccurrence += om.getNbClause(toLit(i));
+
+  vec<Var> order;
+  for(int i = 0 ; i<nbVar ; i++) order.push(i);
+  vec< vec<Lit> > trail(nbVar);
+
+  long int nbUpdate = 0;
+  double time = 0;
+  for(int r = 0 ; r<nbRound ; r++)
+  {
+    for(int i = nbVar - 1 ; i>0 ; i--){ int j = rng() % (i + 1); Var tmp = order[i]; order[i] = order[j]; order[j] = tmp; }
+
+    int depth = nbVar / 2;
+    for(int i = 0 ; i<depth ; i++){ trail[i].clear(); trail[i].push(mkLit(order[i], rng() & 1)); }
+
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0 ; i<depth ; i++) om.preUpdate(trail[i]);
+    for(int i = depth - 1 ; i>=0 ; i--) om.postUpdate(trail[i]);
+    auto end = std::chrono::steady_clock::now();
+
+    time += std::chrono::duration<double, std::nano>(end - start).count();
+    nbUpdate += depth;
+  }
+
+  long int nbAfter = 0;
+  for(int i = 0 ; i<(nbVar << 1) ; i++) nbAfter += om.getNbClause(toLit(i));
+  if(nbAfter != nbOccurrence) printf("c WARNING! the occurrence lists are not restored\n");
+
+  printf("%s: %d variables, %d clauses, %ld occurrences\n", argv[1], nbVar, clauses.size(), nbOccurrence);
+  printf("%ld pre/post updates in %.3f s: %.1f ns per update\n", nbUpdate, time / 1e9, nbUpdate ? time / nbUpdate : 0);
+  return 0;
+}
@@ -0,0 +1,221 @@
+/*
+* d4
+* Copyright (C) 2020  Univ. Artois & CNRS
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+   Cut and time of the built-in multilevel bisection against PaToH
+   (see ../partitioner.sh), on the hypergraphs the CB partitioner
+   builds: the cells are the clauses, the nets the variables. The
+   components are balls of the primal graph of the instance (breadth
+   first search from a random variable) of 10 to 5000 variables, the
+   range of sizes for which d4 calls the partitioner.
+
+   usage: partitioner instance.cnf [nbComponent] [seed]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <random>
+
+#include "../../mtl/Vec.hh"
+#include "../../heuristics/MultilevelBisection.hh"
+#include "../../patoh/patoh.h"
+
+
+/**
+   Read the clauses of a DIMACS file (the other lines are skipped), the
+   variables are numbered from 0.
+ */
+static bool readCnf(const char *fileName, vec<vec<int> > &clauses, int &nbVar)
+{
+  FILE *f = fopen(fileName, "r");
+  if(!f) return false;
+
+  char line[1 << 16];
+  vec<int> cl;
+  nbVar = 0;
+  while(fgets(line, sizeof(line), f))
+  {
+    if(line[0] != '-' && (line[0] < '0' || line[0] > '9') && line[0] != ' ') continue;
+
+    for(char *p = line, *end ; ; p = end)
+    {
+      long v = strtol(p, &end, 10);
+      if(end == p) break;
+      if(!v){ if(cl.size()) clauses.push(); cl.copyTo(clauses.last()); cl.clear(); continue; }
+      if(abs(v) > nbVar) nbVar = abs(v);
+      cl.push(abs(v) - 1);
+    }
+  }
+
+  fclose(f);
+  return clauses.size() > 0;
+}// readCnf
+
+
+/**
+   Hypergraph of a component: the clauses with all their variables in
+   the ball, and the variables of the ball.
+ */
+struct Hypergraph
+{
+  int nbCell, nbNet;
+  vec<int> cwghts, xpins, pins;
+};
+
+
+static void buildComponent(vec<vec<int> > &clauses, vec<vec<int> > &occ, int root, int maxVar, Hypergraph &h,
+                           vec<int> &mapVar)
+{
+  vec<int> ball;
+  ball.push(root);
+  mapVar[root] = 0;
+  for(int i = 0 ; i<ball.size() && ball.size() < maxVar ; i++)
+    for(int j = 0 ; j<occ[ball[i]].size() ; j++)
+    {
+      vec<int> &c = clauses[occ[ball[i]][j]];
+      for(int k = 0 ; k<c.size() && ball.size() < maxVar ; k++)
+        if(mapVar[c[k]] == -1){mapVar[c[k]] = ball.size(); ball.push(c[k]);}
+    }
+
+  vec<int> idxClauses;
+  for(int i = 0 ; i<ball.size() ; i++)
+    for(int j = 0 ; j<occ[ball[i]].size() ; j++)
+    {
+      int idx = occ[ball[i]][j];
+      vec<int> &c = clauses[idx];
+      bool inside = true, first = true;
+      for(int k = 0 ; inside && k<c.size() ; k++)
+      {
+        inside = mapVar[c[k]] != -1;
+        if(inside && mapVar[c[k]] < i) first = false; // counted from a variable seen before
+      }
+      if(inside && first) idxClauses.push(idx);
+    }
+
+  vec<vec<int> > netPins(ball.size());
+  for(int i = 0 ; i<idxClauses.size() ; i++)
+  {
+    vec<int> &c = clauses[idxClauses[i]];
+    for(int k = 0 ; k<c.size() ; k++)
+      if(!netPins[mapVar[c[k]]].size() || netPins[mapVar[c[k]]].last() != i) netPins[mapVar[c[k]]].push(i);
+  }
+
+  h.nbCell = idxClauses.size();
+  h.nbNet = ball.size();
+  h.cwghts.clear();
+  h.cwghts.growTo(h.nbCell, 1);
+  h.xpins.clear();
+  h.pins.clear();
+  h.xpins.push(0);
+  for(int i = 0 ; i<ball.size() ; i++)
+  {
+    for(int j = 0 ; j<netPins[i].size() ; j++) h.pins.push(netPins[i][j]);
+    h.xpins.push(h.pins.size());
+  }
+
+  for(int i = 0 ; i<ball.size() ; i++) mapVar[ball[i]] = -1;
+}// buildComponent
+
+
+static int countCut(Hypergraph &h, int *partvec)
+{
+  int cut = 0;
+  for(int n = 0 ; n<h.nbNet ; n++)
+    for(int j = h.xpins[n] + 1 ; j<h.xpins[n + 1] ; j++)
+      if(partvec[h.pins[j]] != partvec[h.pins[h.xpins[n]]]){cut++; break;}
+  return cut;
+}// countCut
+
+
+int main(int argc, char **argv)
+{
+  if(argc < 2)
+  {
+    fprintf(stderr, "usage: %s instance.cnf [nbComponent] [seed]\n", argv[0]);
+    return 1;
+  }
+
+  vec<vec<int> > clauses;
+  int nbVar;
+  if(!readCnf(argv[1], clauses, nbVar))
+  {
+    fprintf(stderr, "cannot read the clauses of %s\n", argv[1]);
+    return 1;
+  }
+  int nbComponent = argc > 2 ? atoi(argv[2]) : 20;
+  std::mt19937 rng(argc > 3 ? atoi(argv[3]) : 0);
+
+  vec<vec<int> > occ(nbVar);
+  for(int i = 0 ; i<clauses.size() ; i++)
+    for(int j = 0 ; j<clauses[i].size() ; j++) occ[clauses[i][j]].push(i);
+  vec<int> mapVar(nbVar, -1);
+
+  printf("%s: %d variables, %d clauses\n", argv[1], nbVar, clauses.size());
+  printf("%8s %8s %8s | %8s %10s %8s | %8s %10s %8s\n", "#var", "#clause", "#pin",
+         "PaToH", "time(us)", "balance", "ML", "time(us)", "balance");
+
+  MultilevelBisection bisection;
+  int sizes[] = {10, 50, 200, 1000, 5000};
+  for(int s = 0 ; s<5 ; s++)
+  {
+    if(sizes[s] > nbVar) break;
+
+    long int sumCut[2] = {0, 0};
+    double sumTime[2] = {0, 0};
+    int nb = 0;
+    for(int c = 0 ; c<nbComponent ; c++)
+    {
+      Hypergraph h;
+      buildComponent(clauses, occ, rng() % nbVar, sizes[s], h, mapVar);
+      if(h.nbCell < 2) continue;
+
+      vec<int> partvec(h.nbCell + 1), partweights(2);
+      int cut[2];
+      double time[2], balance[2];
+
+      auto start = std::chrono::steady_clock::now();
+      PaToH_Parameters args;
+      PaToH_Initialize_Parameters(&args, PATOH_CONPART, h.nbNet < 200 ? PATOH_SUGPARAM_DEFAULT : PATOH_SUGPARAM_QUALITY);
+      args._k = 2;
+      args.seed = 1;
+      PaToH_Alloc(&args, h.nbCell, h.nbNet, 1, (int *) h.cwghts, NULL, (int *) h.xpins, (int *) h.pins);
+      PaToH_Part(&args, h.nbCell, h.nbNet, 1, 0, (int *) h.cwghts, NULL, (int *) h.xpins, (int *) h.pins,
+                 NULL, (int *) partvec, (int *) partweights, &cut[0]);
+      PaToH_Free();
+      time[0] = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+      cut[0] = countCut(h, partvec);
+      balance[0] = (double) partweights[0] / (partweights[0] + partweights[1]);
+
+      start = std::chrono::steady_clock::now();
+      bisection.bisect(h.nbCell, h.nbNet, h.cwghts, h.xpins, h.pins, partvec, partweights, h.nbNet < 200 ? 1 : ML_NB_RUN_QUALITY);
+      time[1] = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+      cut[1] = countCut(h, partvec);
+      balance[1] = (double) partweights[0] / (partweights[0] + partweights[1]);
+
+      printf("%8d %8d %8d | %8d %10.1f %8.3f | %8d %10.1f %8.3f\n", h.nbNet, h.nbCell, h.pins.size(),
+             cut[0], time[0], balance[0], cut[1], time[1], balance[1]);
+      for(int i = 0 ; i<2 ; i++){sumCut[i] += cut[i]; sumTime[i] += time[i];}
+      nb++;
+    }
+
+    if(nb) printf("size %d: PaToH cut %.1f in %.1f us, ML cut %.1f in %.1f us (average of %d components)\n",
+                  sizes[s], (double) sumCut[0] / nb, sumTime[0] / nb, (double) sumCut[1] / nb, sumTime[1] / nb, nb);
+  }
+
+  return 0;
+}
@@ -0,0 +1,15 @@
+#!/bin/bash
+# Throughput of the updates of the occurrence lists on some instances.
+# usage: ./occurrenceUpdate.sh [nbRound] [instance.cnf ...] (all the CNF of benchTest by default)
+
+DIR=$(dirname $0)
+NBROUND=${1:-1000}; shift
+INSTANCES=${@:-$DIR/*.cnf}
+TMP=$(mktemp -d)
+
+g++ -std=c++11 -O3 -D NDEBUG -o $TMP/occurrenceUpdate $DIR/micro/occurrenceUpdate.cc \
+    $DIR/../manager/dynamicOccurrenceManager.cc $DIR/../manager/CnfOccurrenceManager.cc \
+    $DIR/../utils/Solver.cc $DIR/../utils/System.cc -lz || exit 1
+for f in $INSTANCES; do $TMP/occurrenceUpdate $f $NBROUND; done
+
+rm -rf $TMP
@@ -0,0 +1,14 @@
+#!/bin/bash
+# Cut and time of the built-in hypergraph bisection (-hp=ML) against PaToH (-hp=PATOH).
+# usage: ./partitioner.sh [nbComponent] [instance.cnf ...] (all the CNF of benchTest by default)
+
+DIR=$(dirname $0)
+NBCOMPONENT=${1:-20}; shift
+INSTANCES=${@:-$DIR/*.cnf}
+TMP=$(mktemp -d)
+
+g++ -std=c++11 -O3 -D NDEBUG -o $TMP/partitioner $DIR/micro/partitioner.cc \
+    $DIR/../heuristics/MultilevelBisection.cc $DIR/../patoh/libpatoh.a -lm || exit 1
+for f in $INSTANCES; do $TMP/partitioner $f $NBCOMPONENT; done
+
+rm -rf $TMP
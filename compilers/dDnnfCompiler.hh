@@ -19,6 +19,8 @@
 #define COMPILERS_DDNNF_COMPILER
 
 #include <iostream>
+#include <vector>
+#include <mutex>
 #include <boost/multiprecision/gmp.hpp>
 
 #include "../interfaces/OccurrenceManagerInterface.hh"
@@ -33,6 +35,7 @@
 #include "../utils/SolverTypes.hh"
 #include "../utils/Dimacs.hh"
 #include "../utils/Solver.hh"
+#include "../utils/ContextPool.hh"
 
 #include "../mtl/Sort.hh"
 #include "../mtl/Vec.hh"
@@ -83,6 +86,7 @@ template <class T> class DDnnfCompiler
   unsigned int nbDomainConstraintNode;
   unsigned int nbAndNode, nbAndMinusNode;
   CacheCNF<DAG<T> *> *cache;
+  bool ownCache;
 
   vec<unsigned> stampVar;
   vec<bool> alreadyAdd;
@@ -108,8 +112,16 @@ template <class T> class DDnnfCompiler
   vec<vec<Lit> > clauses;
 
   bool initUnsat;
+  bool verb;
   TmpEntry<DAG<T> *> NULL_CACHE_ENTRY;
 
+  // parallel compilation of the independent components
+  ContextPool<DDnnfCompiler<T> > *pool;
+  bool ownPool;
+  int minVarParallel;
+  int nbParallelComponent;
+  static std::mutex dagLock; // the DAG nodes share static tables (unit literals, free variables, children)
+
 
   /**
      Manage the case where it is unsatisfiable.
@@ -171,7 +183,8 @@ template <class T> class DDnnfCompiler
       vec<DAG<T> *> andDecomposition;
 
       nbSplit += (nbComponent > 1) ? nbComponent : 0;
-      for(int cp = 0 ; cp<nbComponent ; cp++)
+      if(pool && nbComponent > 1) compileParallelComponents(varConnected, priorityVar, andDecomposition, comeFromCache);
+      else for(int cp = 0 ; cp<nbComponent ; cp++)
       {
         vec<Var> &connected = varConnected[cp];
         bool localCache = optCached;
@@ -189,18 +202,11 @@ template <class T> class DDnnfCompiler
           // compute priority list
           vec<Var> currPriority;
           comeFromCache.push(false);
-
-          stampIdx++;
-          for(int i = 0 ; i<connected.size() ; i++) stampVar[connected[i]] = stampIdx;
-          bool propagatePriority = 1 || onB.units.size() < (setOfVar.size() / 10);
-
-          for(int i = 0 ; propagatePriority && i<priorityVar.size() ; i++)
-            if(stampVar[priorityVar[i]] == stampIdx && s.value(priorityVar[i]) == l_Undef)
-              currPriority.push(priorityVar[i]);
+          computePrioritySubSet(connected, priorityVar, currPriority);
 
           ret = compileDecisionNode(connected, currPriority);
           andDecomposition.push(ret);
-          if(localCache) cache->addInCache(cb, ret);
+          if(localCache) cache->addInCache(cb, ret, bm, connected);
         }
         occManager->popPreviousClauseSet();
       }
@@ -213,8 +219,10 @@ template <class T> class DDnnfCompiler
       }
       else
       {
+        std::unique_lock<std::mutex> lock(dagLock);
         if(isCertified) ret = new DecomposableAndNodeCertified<T>(andDecomposition, comeFromCache);
         else ret = new DecomposableAndNode<T>(andDecomposition);
+        lock.unlock();
         nbAndNode++;
 
         // statistics
@@ -240,6 +248,133 @@ template <class T> class DDnnfCompiler
   }// compile_
 
 
+  /**
+     Compute the current priority set.
+   */
+  inline void computePrioritySubSet(vec<Var> &connected, vec<Var> &priorityVar, vec<Var> &currPriority)
+  {
+    currPriority.clear();
+    stampIdx++;
+    for(int i = 0 ; i<connected.size() ; i++) stampVar[connected[i]] = stampIdx;
+    for(int i = 0 ; i<priorityVar.size() ; i++)
+      if(stampVar[priorityVar[i]] == stampIdx && s.value(priorityVar[i]) == l_Undef)
+        currPriority.push(priorityVar[i]);
+  } // computePrioritySubSet
+
+
+  /**
+     Compile independent components. The components that are not in
+     the cache and that are large enough are given to the idle
+     contexts of the pool, the other ones are compiled by the current
+     thread. The cache of this compiler is searched and filled as in
+     the sequential case.
+
+     @param[in] varConnected, the components
+     @param[in] priorityVar, select in priority these variable to the next decision node
+     @param[out] andDecomposition, the DAG compiled for each component
+     @param[out] comeFromCache, for each component, true if its DAG comes from the cache
+  */
+  void compileParallelComponents(vec< vec<Var> > &varConnected, vec<Var> &priorityVar,
+                                 vec<DAG<T> *> &andDecomposition, vec<bool> &comeFromCache)
+  {
+    int nbComponent = varConnected.size();
+    std::vector<TmpEntry<DAG<T> *> > entries(nbComponent);
+    vec< vec<Var> > currPriority(nbComponent);
+    vec<int> launched(nbComponent, -1);
+    vec<Lit> context;
+    bool contextBuilt = false;
+
+    andDecomposition.growTo(nbComponent, NULL);
+    comeFromCache.growTo(nbComponent, false);
+
+    // search in the cache and give away the large components
+    for(int cp = 0 ; cp<nbComponent ; cp++)
+    {
+      vec<Var> &connected = varConnected[cp];
+
+      occManager->updateCurrentClauseSet(connected);
+      entries[cp] = optCached ? cache->searchInCache(connected, bm) : NULL_CACHE_ENTRY;
+      occManager->popPreviousClauseSet();
+
+      if(entries[cp].defined)
+      {
+        comeFromCache[cp] = true;
+        andDecomposition[cp] = entries[cp].getValue();
+        continue;
+      }
+
+      computePrioritySubSet(connected, priorityVar, currPriority[cp]);
+      if(connected.size() < minVarParallel) continue;
+
+      if(!contextBuilt)
+      {
+        for(int i = 0 ; i<s.nVars() ; i++)
+          if(s.value(i) != l_Undef) context.push(mkLit(i, s.value(i) == l_False));
+        contextBuilt = true;
+      }
+
+      vec<Var> &prio = currPriority[cp];
+      DAG<T> *&res = andDecomposition[cp];
+      launched[cp] = pool->tryLaunch([&context, &connected, &prio, &res](DDnnfCompiler<T> *c)
+                                     { res = c->compileDetachedComponent(context, connected, prio); });
+    }
+
+    // the remaining components are compiled here
+    for(int cp = 0 ; cp<nbComponent ; cp++)
+    {
+      if(entries[cp].defined || launched[cp] >= 0) continue;
+
+      occManager->updateCurrentClauseSet(varConnected[cp]);
+      andDecomposition[cp] = compileComponent(varConnected[cp], currPriority[cp]);
+      occManager->popPreviousClauseSet();
+    }
+
+    for(int cp = 0 ; cp<nbComponent ; cp++)
+    {
+      if(launched[cp] >= 0)
+      {
+        pool->wait(launched[cp]);
+        nbParallelComponent++;
+      }
+
+      if(optCached && !entries[cp].defined)
+      {
+        occManager->updateCurrentClauseSet(varConnected[cp]);
+        cache->addInCache(entries[cp], andDecomposition[cp], bm, varConnected[cp]);
+        occManager->popPreviousClauseSet();
+      }
+    }
+  }// compileParallelComponents
+
+
+  /**
+     Compile a component at the current level. The clauses learnt
+     since the component was built can have assigned some of its
+     variables, or all of them: the solver is called again and these
+     literals are kept on a unary node.
+
+     @param[in] component, the variables of the component
+     @param[in] priorityVar, select in priority these variable to the next decision node
+     \return the compiled component
+  */
+  DAG<T> *compileComponent(vec<Var> &component, vec<Var> &priorityVar)
+  {
+    vec<int> idxReason;
+    onTheBranch onB;
+    bool fromCache;
+
+    DAG<T> *ret = compile_(component, priorityVar, lit_Undef, onB, fromCache, idxReason);
+    if(ret == globalFalseNode) return ret;
+
+    if(onB.units.size() || onB.free.size())
+    {
+      std::lock_guard<std::mutex> lock(dagLock);
+      ret = new UnaryNode<T>(ret, onB.units, onB.free);
+    }
+    return ret;
+  }// compileComponent
+
+
   /**
      Create a decision node in purpose.
   */
@@ -247,6 +382,7 @@ template <class T> class DDnnfCompiler
                                    DAG<T> *neg, onTheBranch &bNeg, bool fromCacheNeg,
                                    vec<int> &idxReason)
   {
+    std::lock_guard<std::mutex> lock(dagLock);
     if(isCertified)
       return new BinaryDeterministicOrNodeCertified<T>(pos, bPos.units, bPos.free, fromCachePos,
                                                neg, bNeg.units, bNeg.free, fromCacheNeg, idxReason);
@@ -262,14 +398,13 @@ template <class T> class DDnnfCompiler
   */
   DAG<T> *compileDecisionNode(vec<Var> &connected, vec<Var> &priorityVar)
   {
-    if(s.assumptions.size() && s.assumptions.size() < 5){cout << "c top 5: "; showListLit(s.assumptions);}
+    if(verb && s.assumptions.size() && s.assumptions.size() < 5){cout << "c top 5: "; showListLit(s.assumptions);}
 
     bool weCall = false;
-    if(pv && !priorityVar.size() && connected.size() > 10 && connected.size() < 5000)
+    if(pv && !priorityVar.size() && pv->isUsedOn(connected.size()))
     {
       weCall = true;
-      vec<int> cutSet;
-      pv->computePartition(connected, cutSet, priorityVar, vs->getScoringFunction());
+      bool inCache = pv->computeCut(connected, priorityVar, vs->getScoringFunction());
 
       // normally priority var is a subset of connect ???
       for(int i = 0 ; i<priorityVar.size() ; i++)
@@ -279,7 +414,7 @@ template <class T> class DDnnfCompiler
         assert(isIn);
       }
 
-      callPartitioner++;
+      if(!inCache) callPartitioner++;
     }
 
     Var v = var_Undef;
@@ -345,6 +480,10 @@ template <class T> class DDnnfCompiler
     printf("c Number of decomposable AND nodes: %u\n", nbAndNode);
     printf("c Number of backbone calls: %u\n", callEquiv);
     printf("c Number of partitioner calls: %u\n", callPartitioner);
+    if(pv) pv->printStatistics();
+    printf("c Number of occurrences visited to find the components: %lu (%lu avoided)\n",
+           occManager->getNbComponentVisit(), occManager->getNbAvoidedComponentVisit());
+    if(pool) printf("c Number of components compiled by another context: %d\n", nbParallelComponent);
     printf("c Average number of assigned literal to obtain decomposable AND nodes: %.2lf/%d\n",
            nbAndNode ? sumAffectedAndNode / nbAndNode : s.nVars(), s.nVars());
     printf("c Minimum number of assigned variable where a decomposable AND appeared: %u\n", minAffectedAndNode);
@@ -360,6 +499,7 @@ template <class T> class DDnnfCompiler
 
   inline void showRun()
   {
+    if(!verb) return;
     if(!(nbCallCompile & (MASK_HEADER))) showHeader();
     if(nbCallCompile && !(nbCallCompile & MASK)) showInter();
   }
@@ -372,6 +512,7 @@ template <class T> class DDnnfCompiler
     s.collectUnit(setOfVar, unitLit); // collect unit literals
     if(unitLit.size())
     {
+      std::lock_guard<std::mutex> lock(dagLock);
       vec<Var> freeVar;
       if(!isCertified) return new UnaryNode<T>(globalTrueNode, unitLit, freeVar);
 
@@ -388,6 +529,74 @@ template <class T> class DDnnfCompiler
     return globalTrueNode;
   }// createTrueNode
 
+  /**
+     Initialize the data structures of the compiler once the solver
+     knows the formula (which is satisfiable).
+
+     @param[in] optList, the options
+     @param[in] isProjectedVar, boolean vector used to decide if a variable is projected (true) or not (false)
+     @param[in] ref, the compiler we take the clauses and the cache from (NULL if none)
+   */
+  void init(OptionManager &optList, vec<bool> &isProjectedVar, DDnnfCompiler<T> *ref)
+  {
+    s.simplify();
+    s.remove_satisfied = false;
+    s.setNeedModel(false);
+
+    callPartitioner = callEquiv = 0;
+    optCached = optList.optCache;
+    optDecomposableAndNode = optList.optDecomposableAndNode;
+    optReversePolarity = optList.reversePolarity;
+    if(verb) optList.printOptions();
+
+    // initialized the data structure
+    if(ref)
+    {
+      for(int i = 0 ; i<ref->clauses.size() ; i++)
+      {
+        clauses.push();
+        ref->clauses[i].copyTo(clauses.last());
+      }
+    }
+    else prepareVecClauses(clauses, s);
+    occManager = new DynamicOccurrenceManager(clauses, s.nVars());
+
+    freqLimitDyn = optList.freqLimitDyn;
+    ownCache = !ref;
+    if(ref) cache = ref->cache;
+    else
+    {
+      cache = new CacheCNF<DAG<T> *>(optList.reduceCache, optList.strategyRedCache);
+      cache->initHashTable(occManager->getNbVariable(), occManager->getNbClause(),
+                           occManager->getMaxSizeClause());
+      cache->setMemoryBudget(optList.cacheMemory);
+      cache->setAdmissionPolicy(optList.cacheAdmission, optList.cacheMinVar, optList.cacheMaxVar);
+    }
+
+    vs = new VariableHeuristicInterface(s, occManager, optList.varHeuristic,
+                                        optList.phaseHeuristic, isProjectedVar);
+    bm = new BucketManager<DAG<T> *>(occManager, optList.strategyRedCache);
+    bm->setRepresentation(optList.cacheRepresentation);
+    pv = PartitionerInterface::getPartitioner(s, occManager, optList);
+    if(ref && pv) pv->shareWith(ref->pv);
+
+    alreadyAdd.initialize(s.nVars(), false);
+
+    stampIdx = 0;
+    stampVar.initialize(s.nVars(), 0);
+    em.initEquivManager(s.nVars());
+
+    globalTrueNode = new trueNode<T>();
+    globalFalseNode = new falseNode<T>();
+
+    // statistics initialization
+    minAffectedAndNode = s.nVars();
+    nbSplit = nbCallCompile = 0;
+    currentTime = cpuTime();
+    nbAndMinusNode = nbAndNode = nbDecisionNode = nbDomainConstraintNode = nbNodeInCompile = 0;
+    sumAffectedAndNode = 0;
+  }// init
+
  public:
   /**
      Constructor of dDNNF compiler.
@@ -400,72 +609,142 @@ template <class T> class DDnnfCompiler
      @param[in] _pv, the partitioner heuristic name
      @param[in] rp, true if we reverse the polarity, false otherwise
      @param[in] isProjectedVar, boolean vector used to decide if a variable is projected (true) or not (false)
+     @param[in] certif, the stream where the drat proof is written (NULL if not certified)
+     @param[in] _verb, the main compiler prints its options and progression, and fills the tables shared by the DAG nodes
   */
   DDnnfCompiler(vec<vec<Lit> > &cnf, vec<double> &wl, OptionManager &optList, vec<bool> &isProjectedVar,
-                ostream *certif) : s(certif)
+                ostream *certif, bool _verb = true) : s(certif)
   {
+    verb = _verb;
+    pool = NULL;
+    ownPool = false;
+    minVarParallel = optList.minVarParallel;
+    nbParallelComponent = 0;
+
     isCertified = certif != NULL;
     for(int i = 0 ; i<wl.size()>>1 ; i++) s.newVar();
     for(int i = 0 ; i<cnf.size() ; i++) s.addClause_(cnf[i]);
 
     initUnsat = !s.solveWithAssumptions();
+    if(!initUnsat) init(optList, isProjectedVar, NULL);
 
-    if(!initUnsat)
+    if(verb)
     {
-      s.simplify();
-      s.remove_satisfied = false;
-      s.setNeedModel(false);
-
-      callPartitioner = callEquiv = 0;
-      optCached = optList.optCache;
-      optDecomposableAndNode = optList.optDecomposableAndNode;
-      optReversePolarity = optList.reversePolarity;
-      optList.printOptions();
+      isProjectedVar.copyTo(DAG<T>::varProjected);
+      wl.copyTo(DAG<T>::weights);
+      for(int i = 0 ; i<s.nVars() ; i++) DAG<T>::weightsVar.push(wl[i<<1] + wl[(i<<1) | 1]);
+    }
+    if (!initUnsat) cache->setInfoFormula(s.nVars(), cnf.size(), occManager->getMaxSizeClause());
+  }// DDnnfCompiler
 
-      // initialized the data structure
-      prepareVecClauses(clauses, s);
-      occManager = new DynamicOccurrenceManager(clauses, s.nVars());
 
-      freqLimitDyn = optList.freqLimitDyn;
-      cache = new CacheCNF<DAG<T> *>(optList.reduceCache, optList.strategyRedCache);
-      cache->initHashTable(occManager->getNbVariable(), occManager->getNbClause(),
-                           occManager->getMaxSizeClause());
+  ~DDnnfCompiler()
+  {
+    if(ownPool) delete pool;
+    if(pv) delete pv;
+    if(ownCache) delete cache;
+    delete vs; delete bm;
+    delete occManager;
+  }
 
-      vs = new VariableHeuristicInterface(s, occManager, optList.varHeuristic,
-                                          optList.phaseHeuristic, isProjectedVar);
-      bm = new BucketManager<DAG<T> *>(occManager, optList.strategyRedCache);
-      pv = PartitionerInterface::getPartitioner(s, occManager, optList);
+  /**
+     Constructor of a compiler that works on the same formula as ref
+     and shares its cache. The clauses of the occurrence manager are
+     exactly the ones of ref (same order), which is required for the
+     cache entries built by one compiler to be understood by the other
+     one. This compiler does not print anything.
+
+     @param[in] ref, the compiler we share the cache with
+     @param[in] wl, the vector of literal's weight
+     @param[in] optList, the options
+     @param[in] isProjectedVar, boolean vector used to decide if a variable is projected (true) or not (false)
+  */
+  DDnnfCompiler(DDnnfCompiler<T> &ref, vec<double> &wl, OptionManager &optList, vec<bool> &isProjectedVar)
+    : s(NULL)
+  {
+    verb = false;
+    pool = NULL;
+    ownPool = false;
+    minVarParallel = optList.minVarParallel;
+    nbParallelComponent = 0;
+    isCertified = false;
+
+    // the solver gets the simplified formula and the units of ref
+    for(int i = 0 ; i<wl.size()>>1 ; i++) s.newVar();
+    vec<Lit> cl;
+    for(int i = 0 ; i<ref.s.nVars() ; i++)
+      if(ref.s.value(i) != l_Undef)
+      {
+        cl.clear();
+        cl.push(mkLit(i, ref.s.value(i) == l_False));
+        s.addClause_(cl);
+      }
+    for(int i = 0 ; i<ref.clauses.size() ; i++)
+    {
+      ref.clauses[i].copyTo(cl);
+      s.addClause_(cl);
+    }
 
-      alreadyAdd.initialize(s.nVars(), false);
+    initUnsat = !s.solveWithAssumptions();
+    assert(!initUnsat);
+    init(optList, isProjectedVar, &ref);
+  }// DDnnfCompiler
 
-      stampIdx = 0;
-      stampVar.initialize(s.nVars(), 0);
-      em.initEquivManager(s.nVars());
 
-      globalTrueNode = new trueNode<T>();
-      globalFalseNode = new falseNode<T>();
+  /**
+     Create nbContext other compilers on the same formula, run by
+     their own thread, to which the large independent components are
+     given (see compileParallelComponents). All the contexts share the
+     cache of this compiler. Not available in certified mode since the
+     proof is written by the solver of the main compiler.
+
+     @param[in] wl, the vector of literal's weight
+     @param[in] optList, the options
+     @param[in] isProjectedVar, boolean vector used to decide if a variable is projected (true) or not (false)
+     @param[in] nbContext, the number of contexts created
+   */
+  void initContextPool(vec<double> &wl, OptionManager &optList, vec<bool> &isProjectedVar, int nbContext)
+  {
+    if(isCertified || initUnsat) return;
 
-      // statistics initialization
-      minAffectedAndNode = s.nVars();
-      nbSplit = nbCallCompile = 0;
-      currentTime = cpuTime();
-      nbAndMinusNode = nbAndNode = nbDecisionNode = nbDomainConstraintNode = nbNodeInCompile = 0;
-      sumAffectedAndNode = 0;
-    }
+    vec<DDnnfCompiler<T> *> contexts;
+    for(int i = 0 ; i<nbContext ; i++) contexts.push(new DDnnfCompiler<T>(*this, wl, optList, isProjectedVar));
+    cache->setShared(true);
 
-    isProjectedVar.copyTo(DAG<T>::varProjected);
-    wl.copyTo(DAG<T>::weights);
-    for(int i = 0 ; i<s.nVars() ; i++) DAG<T>::weightsVar.push(wl[i<<1] + wl[(i<<1) | 1]);
-    if (!initUnsat) cache->setInfoFormula(s.nVars(), cnf.size(), occManager->getMaxSizeClause());
-  }// DDnnfCompiler
+    pool = new ContextPool<DDnnfCompiler<T> >(contexts);
+    ownPool = true;
+    for(int i = 0 ; i<nbContext ; i++) pool->getContext(i)->pool = pool;
+  }// initContextPool
 
 
-  ~DDnnfCompiler()
+  /**
+     Compile a component given by another compiler: the solver and
+     the occurrence manager are first put in the state of the caller,
+     described by the set of literals it has assigned. Since the learnt
+     clauses differ, this solver can propagate more literals of the
+     component than the caller, they are kept on a unary node.
+
+     @param[in] context, the literals assigned by the caller
+     @param[in] component, the variables of the component
+     @param[in] priorityVar, select in priority these variable to the next decision node
+     \return the compiled component
+   */
+  DAG<T> *compileDetachedComponent(vec<Lit> &context, vec<Var> &component, vec<Var> &priorityVar)
   {
-    if(pv) delete pv;
-    delete cache; delete vs; delete bm;
-    delete occManager;
-  }
+    vec<Var> currPriority;
+    priorityVar.copyTo(currPriority);
+
+    s.cancelUntil(0);
+    context.copyTo(s.assumptions);
+    occManager->preUpdate(context);
+    DAG<T> *ret = compileComponent(component, currPriority);
+    occManager->postUpdate(context);
+    s.cancelUntil(0);
+    s.assumptions.clear();
+
+    return ret;
+  }// compileDetachedComponent
+
 
   /**
      Compile the CNF formula into a dDNNF structure.
@@ -500,4 +779,6 @@ template <class T> class DDnnfCompiler
   }// compile
 };
 
+template<class T> std::mutex DDnnfCompiler<T>::dagLock;
+
 #endif
@@ -21,9 +21,11 @@
 
 #include "../manager/OptionManager.hh"
 #include "../modelCounters/ModelCounter.hh"
+#include "../modelCounters/ParallelModelCounter.hh"
 
 #include "../compilers/dDnnfCompiler.hh"
 #include "../preproc/Preproc.hh"
+#include "../core/QueryServer.hh"
 
 #include "../utils/System.hh"
 #include "../utils/Options.hh"
@@ -71,16 +73,39 @@ using namespace std;
 template<typename T> void modelCounting(vec<vec<Lit> > &clauses, vec<double> &weightLit,
                                         OptionManager &optList, vec<bool> &isProjectedVar)
 {
-  ModelCounter<T> *tmp = new ModelCounter<T>(clauses, weightLit, optList, isProjectedVar);
-  T d = tmp->computeNbModel();
-  cout << std::fixed << "s " << d << endl;
-  delete tmp;
+  if(optList.nbThreads > 1 && !strcmp(optList.parallelMode, "CUBE"))
+    {
+      ParallelModelCounter<T> *tmp = new ParallelModelCounter<T>(clauses, weightLit, optList, isProjectedVar);
+      if(*optList.cacheLoad) tmp->loadPersistentCache(optList.cacheLoad);
+      T d = tmp->computeNbModel();
+      if(*optList.cacheSave) tmp->savePersistentCache(optList.cacheSave);
+      cout << std::fixed << "s " << d << endl;
+      delete tmp;
+    }
+  else
+    {
+      ModelCounter<T> *tmp = new ModelCounter<T>(clauses, weightLit, optList, isProjectedVar);
+      if(optList.nbThreads > 1)
+        tmp->initContextPool(weightLit, optList, isProjectedVar, optList.nbThreads - 1);
+      if(*optList.cacheLoad) tmp->loadPersistentCache(optList.cacheLoad);
+      T d = tmp->computeNbModel();
+      if(*optList.cacheSave) tmp->savePersistentCache(optList.cacheSave);
+      cout << std::fixed << "s " << d << endl;
+      delete tmp;
+    }
 }// modelCounting
 
 
-template<typename T> void runQueries(DAG<T> *t)
+/**
+   Answer the queries given on the standard input.
+
+   @param[in] t, a compiled DAG or a BinaryNNF
+ */
+template<typename T, class D> void runQueries(D *t)
 {
   vec<Lit> queryRead;
+  double start = cpuTime();
+  int nbQuery = 0;
 
   do
     {
@@ -105,6 +130,7 @@ template<typename T> void runQueries(DAG<T> *t)
             {
               cout << "c query: ";
               showListLit(queryRead);
+              nbQuery++;
 
               if(type == 'm')
                 {
@@ -118,9 +144,128 @@ template<typename T> void runQueries(DAG<T> *t)
             }
         }
     }while(queryRead.size());
+
+  printf("c %d queries computed in %.3lf s\n", nbQuery, cpuTime() - start);
 }// runQueries
 
 
+/**
+   Write a compiled DAG in the binary format (see DAG/BinaryNNF.hh).
+
+   @param[in] t, the DAG
+   @param[in] fileName, the path
+ */
+template<typename T> void saveBinaryNNF(DAG<T> *t, const char *fileName)
+{
+  double start = cpuTime();
+  BinaryNNFWriter w;
+  t->writeBinaryNNF(w);
+
+  if(!w.save(fileName, DAG<T>::weights, DAG<T>::varProjected))
+    printf("c WARNING! Could not write the binary d-DNNF file %s?\n", fileName);
+  else printf("c Binary d-DNNF: %lu nodes, %lu arcs written in %.3lf s\n",
+              (unsigned long) w.getNbNode(), (unsigned long) w.getNbArc(), cpuTime() - start);
+}// saveBinaryNNF
+
+
+/**
+   Run the query server (see core/QueryServer.hh) on a binary d-DNNF.
+
+   @param[in] m, the mapped d-DNNF
+   @param[in] where, "-" for the standard input/output, the path of a Unix socket otherwise
+   @param[in] nbThreads, the number of workers
+   @param[in] countMode, how the counts are computed: EXACT, DOUBLE or LOG
+ */
+template<typename T> void serveQueries(BinaryNNFMapping &m, const char *where, int nbThreads, const char *countMode)
+{
+  QueryServer<T> server(m, nbThreads, countMode);
+  if(!server.serve(where))
+    {
+      fprintf(stderr, "%s: cannot listen on this socket\n", where);
+      exit(37);
+    }
+}// serveQueries
+
+
+/**
+   Flatten a compiled DAG in the binary representation, kept in memory
+   (see BinaryNNFMapping::freeze).
+
+   @param[in] t, the DAG
+   @param[out] m, the flattened d-DNNF
+ */
+template<typename T> void freezeDAG(DAG<T> *t, BinaryNNFMapping &m)
+{
+  double start = cpuTime();
+  BinaryNNFWriter w;
+  t->writeBinaryNNF(w);
+  if(!m.freeze(w, DAG<T>::weights, DAG<T>::varProjected))
+    {
+      fprintf(stderr, "the flattened d-DNNF is not valid\n");
+      exit(36);
+    }
+  printf("c Frozen d-DNNF: %lu nodes, %lu arcs in %.3lf s\n", (unsigned long) w.getNbNode(),
+         (unsigned long) w.getNbArc(), cpuTime() - start);
+}// freezeDAG
+
+
+/**
+   Print the weighted count of the formula conditioned by each literal
+   ("m <literal> <count>"), after the count without conditioning.
+
+   @param[in] m, the mapped d-DNNF
+ */
+template<typename T> void printMarginals(BinaryNNFMapping &m)
+{
+  double start = cpuTime();
+  BinaryNNF<T> nnf(m);
+  std::vector<T> res;
+  T total = nnf.computeMarginals(res);
+  printf("c Marginals computed in %.3lf s\n", cpuTime() - start);
+
+  cout << std::fixed << "s " << total << "\n";
+  for(unsigned v = 0 ; v<m.header->nbVar ; v++)
+    {
+      cout << "m " << (v + 1) << " " << res[toInt(mkLit(v, false))] << "\n";
+      cout << "m -" << (v + 1) << " " << res[toInt(mkLit(v, true))] << "\n";
+    }
+  cout.flush();
+}// printMarginals
+
+
+/**
+   Count the models of a binary d-DNNF, or answer the queries.
+
+   @param[in] m, the mapped d-DNNF
+   @param[in] query, true if the queries are read on the standard input
+   @param[in] server, where the query server reads the queries ("" if it is not used)
+   @param[in] nbThreads, the number of workers of the query server
+   @param[in] countMode, how the query server computes the counts
+   @param[in] marginals, true if the count conditioned by each literal is printed
+ */
+template<typename T> void countBinaryNNF(BinaryNNFMapping &m, bool query, const char *server, int nbThreads,
+                                         const char *countMode, bool marginals)
+{
+  BinaryNNF<T> nnf(m);
+  BinaryNNFIndex<T> index;
+  if(*server) serveQueries<T>(m, server, nbThreads, countMode);
+  else if(marginals) printMarginals<T>(m);
+  else if(query)
+    {
+      nnf.buildIndex(index);
+      nnf.setIndex(&index);
+      runQueries<T>(&nnf);
+    }
+  else
+    {
+      double start = cpuTime();
+      T t1 = nnf.computeNbModels();
+      printf("c Count computed in %.3lf s\n", cpuTime() - start);
+      cout << std::fixed << "s " << t1 << endl;
+    }
+}// countBinaryNNF
+
+
 /**
    Compile a CNF formula into a d-DNNF formula.
 
@@ -131,16 +276,27 @@ template<typename T> void runQueries(DAG<T> *t)
    @param[in] isProjectedVar, boolean vector used to decide if a variable is projected (true) or not (false)
 */
 template<typename T> void compileDDNNF(vec<vec<Lit> > &cls, vec<double> &wLit, OptionManager &opt, ostream* out,
-                                       vec<bool> &isProjectedVar, bool query, ostream* dratOut)
+                                       vec<bool> &isProjectedVar, bool query, ostream* dratOut, const char *binOut,
+                                       const char *server, const char *countMode, bool marginals, bool freeze)
 {
   DDnnfCompiler<T> *dDnnfCompiler = new DDnnfCompiler<T>(cls, wLit, opt, isProjectedVar, dratOut);
+  if(opt.nbThreads > 1) dDnnfCompiler->initContextPool(wLit, opt, isProjectedVar, opt.nbThreads - 1);
   DAG<T> *t = dDnnfCompiler->compile();
   if(out != nullptr) t->printNNF(*out, dratOut);
+  if(*binOut) saveBinaryNNF(t, binOut);
 
-  if(query) runQueries<T>(t);
+  if(*server || marginals || freeze)
+    {
+      BinaryNNFMapping m;
+      freezeDAG(t, m);
+      countBinaryNNF<T>(m, query, server, opt.nbThreads, countMode, marginals);
+    }
+  else if(query) runQueries<T>(t);
   else
     {
+      double start = cpuTime();
       T t1 = t->computeNbModels();
+      printf("c Count computed in %.3lf s\n", cpuTime() - start);
       cout << std::fixed << "s " << t1 << endl;
     }
 }// compileDDNNF
@@ -207,6 +363,18 @@ int main(int argc, char** argv)
   BoolOption dDNNF("MAIN", "dDNNF", "Compile the problem into a decision-DNNF formula\n", false);
   BoolOption printCNF("MAIN", "print", "Print the input formula (maybe after applying preproc)\n", false);
   BoolOption query("MAIN", "query", "Compute a set of queries given on the input stream\n", false);
+  BoolOption loadBinary("MAIN", "load-bin",
+                "The input file is a d-DNNF written with -out-bin: count its models or compute the queries\n", false);
+  BoolOption freeze("MAIN", "freeze",
+                "Flatten the compiled DAG in arrays to compute the count and the queries (with -dDNNF)\n", false);
+  BoolOption marginals("MAIN", "marginals",
+                "Print the count conditioned by each literal (with -dDNNF or -load-bin)\n", false);
+  StringOption server("MAIN", "server",
+                "Answer the queries of -query for several clients, on the standard input/output (-) or on a Unix\n"
+                "socket (its path), with -dDNNF or -load-bin (-threads gives the number of workers)\n", "");
+  StringOption serverCount("MAIN", "server-count",
+                "Counts of the query server: EXACT, DOUBLE or LOG (approximate, several queries per pass,\n"
+                "LOG does not overflow)\n", "EXACT");
 
   // options:
   BoolOption optAnd("MAIN", "optAnd", "And decomposition activate\n", true);
@@ -218,17 +386,26 @@ int main(int argc, char** argv)
   StringOption cacheStore("MAIN", "cs",
                 "Define which part of the formula is cached: ALL, NB (no binary), NT (no touche)\n",
                 "NT");
-  StringOption cacheRepresentation("MAIN", "cr", "CL\n", "CL");
+  StringOption cacheRepresentation("MAIN", "cr",
+                "Representation of the cached formulas: CL (clauses), CP (compressed clauses)\n", "CL");
   StringOption varHeuristic("MAIN", "vh", "Heuristic implemented: VSADS, VSIDS, DLCS, JW-TS, MOM\n", "VSADS");
   StringOption phaseHeuristic("MAIN", "ph", "Heuristic implemented: TRUE, FALSE, POLARITY, OCCURRENCE\n", "TRUE");
   StringOption partitionHeuristic("MAIN", "pv",
-                "Partition Variable Heuristic implemented: NO, CB (clause bipartite) and VB (var bipartite)\n",
+                "Partition Variable Heuristic implemented: NO, CB (clause bipartite), VB (var bipartite)\n"
+                "and TD (tree decomposition)\n",
                 "CB");
+  StringOption hypergraphPartitioner("MAIN", "hp",
+                "Hypergraph partitioner used by CB and VB: ML (built-in multilevel bisection), PATOH\n", "ML");
   StringOption fileWeights("MAIN", "wFile", "File where we can find for some literals a weight", "/dev/null");
   StringOption ddnnfOutput("MAIN", "out",
                 "File where the d-DNNF representation of the DAG should be output", "/dev/null");
+  StringOption binaryOutput("MAIN", "out-bin",
+                "File where the d-DNNF representation is written in binary form (read with -load-bin)", "");
   StringOption dratOutput("MAIN", "drat", "File where the drat should be output", "/dev/null");
 
+  StringOption cacheLoad("MAIN", "cache-load",
+               "File from which the cache of the model counter is loaded (written by -cache-save)", "");
+  StringOption cacheSave("MAIN", "cache-save", "File where the cache of the model counter is saved", "");
   StringOption fileP("MAIN", "fpv", "File where we can find the projected variable", "/dev/null");
   StringOption optPreproc("MAIN", "preproc",
                "Available preproc: backbone, vivification, occElimination (can be combine with +)", "");
@@ -241,12 +418,80 @@ int main(int argc, char** argv)
   IntOption freqLimitDyn("MAIN",
                "frequence-update-limit", "Set the periodicity to update the size limit of we cache\n",
                18, IntRange(0, 31));
+  DoubleOption cacheMemory("MAIN", "cache-mem",
+               "Memory budget (in GB) of the cache, entries are evicted beyond it (0 = no limit)\n",
+               0, DoubleRange(0, true, HUGE_VAL, false));
   IntOption strategyRedCache("MAIN", "strategy-reduce-cache",
                "Set the strategy for the aging about the cache entries (0 = dec, 1 = div)\n", 0, IntRange(0,2));
+  IntOption nbThreads("MAIN", "threads", "Number of threads used to count the models or to compile\n",
+                      1, IntRange(1, 1024));
+  IntOption splitDepth("MAIN", "split-depth",
+               "Number of decisions split into parallel tasks (0 = computed from the number of threads)\n",
+               0, IntRange(0, 30));
+  StringOption parallelMode("MAIN", "pm",
+               "Parallel mode: CUBE (split the decision tree, -mc only) or COMP (independent components)\n",
+               "CUBE");
+  IntOption minVarParallel("MAIN", "pm-min-var",
+               "Minimal number of variables of a component given to another thread (COMP mode)\n",
+               32, IntRange(1, INT32_MAX));
+  StringOption cacheAdmission("MAIN", "cache-admit",
+               "Formulas stored in the cache: ALL, SECOND (missed twice), FREQ (searched twice recently)\n",
+               "ALL");
+  IntOption cacheMinVar("MAIN", "cache-min-var",
+               "Minimal number of variables of the formulas stored in the cache\n", 0, IntRange(0, INT32_MAX));
+  IntOption cacheMaxVar("MAIN", "cache-max-var",
+               "Maximal number of variables of the formulas stored in the cache (0 = no limit)\n",
+               0, IntRange(0, INT32_MAX));
 
 
   parseOptions(argc, argv, true);
 
+  if(strcmp(parallelMode, "CUBE") && strcmp(parallelMode, "COMP"))
+    {
+      fprintf(stderr, "%s: this parallel mode is unknow\n", (const char *) parallelMode);
+      exit(33);
+    }
+
+  if(!PartitionerInterface::isHypergraphPartitioner(hypergraphPartitioner))
+    {
+      fprintf(stderr, "%s: this hypergraph partitioner is unknow\n", (const char *) hypergraphPartitioner);
+      exit(35);
+    }
+
+  if(!CacheAdmissionInterface::isPolicy(cacheAdmission))
+    {
+      fprintf(stderr, "%s: this cache admission policy is unknow\n", (const char *) cacheAdmission);
+      exit(34);
+    }
+
+  if(!isServerCountMode(serverCount))
+    {
+      fprintf(stderr, "%s: this count mode is unknow\n", (const char *) serverCount);
+      exit(38);
+    }
+
+  if(loadBinary)
+    {
+      BinaryNNFMapping m;
+      if(!m.load(argv[1]))
+        {
+          fprintf(stderr, "%s: this file is not a binary d-DNNF\n", argv[1]);
+          exit(36);
+        }
+
+      printf("c Binary d-DNNF: %lu nodes, %lu arcs, %u variables\n", (unsigned long) m.header->nbNode,
+             (unsigned long) m.header->nbArc, m.header->nbVar);
+      bool isInteger = m.hasIntegerWeights();
+      cout << "c " << (isInteger ? "Integer" : "Float") << " mode " << endl;
+      if(isInteger) countBinaryNNF<mpz_int>(m, query, server, nbThreads, serverCount, marginals);
+      else
+        {
+          mpf_float::default_precision(precision);
+          countBinaryNNF<mpf_float>(m, query, server, nbThreads, serverCount, marginals);
+        }
+      exit(0);
+    }
+
   ofstream out{ddnnfOutput};
   if (!out.is_open()) printf("c WARNING! Could not write output d-DNNF file %s?\n", (const char *) ddnnfOutput);
 
@@ -255,7 +500,9 @@ int main(int argc, char** argv)
 
   OptionManager optList(optCache, optAnd, rPolarity, reducePrimalGraph, equivSimp, cacheStore, varHeuristic,
                         phaseHeuristic, partitionHeuristic, cacheRepresentation, reduceCache,
-                        strategyRedCache, freqLimitDyn);
+                        strategyRedCache, freqLimitDyn, nbThreads, splitDepth,
+                        parallelMode, minVarParallel, cacheMemory, cacheLoad, cacheSave,
+                        cacheAdmission, cacheMinVar, cacheMaxVar, hypergraphPartitioner);
 
   // parse the input: CNF, weight of the literal and projected variables
   vec<vec<Lit> > clauses;
@@ -293,8 +540,10 @@ int main(int argc, char** argv)
       ofstream *outFile = (strcmp((const char*)ddnnfOutput, "/dev/null") == 0) ? nullptr: &out;
       ofstream *dratFile = (strcmp((const char*)dratOutput, "/dev/null") == 0) ? nullptr: &dratOut;
 
-      if(isInteger) compileDDNNF<mpz_int>(clauses, weightLit, optList, outFile, isProjectedVar, query, dratFile);
-      else compileDDNNF<mpf_float>(clauses, weightLit, optList, outFile, isProjectedVar, query, dratFile);
+      if(isInteger) compileDDNNF<mpz_int>(clauses, weightLit, optList, outFile, isProjectedVar, query, dratFile,
+                                           binaryOutput, server, serverCount, marginals, freeze);
+      else compileDDNNF<mpf_float>(clauses, weightLit, optList, outFile, isProjectedVar, query, dratFile,
+                                             binaryOutput, server, serverCount, marginals, freeze);
 
       if (dratFile) dratFile->close();
       if(outFile) outFile->close();
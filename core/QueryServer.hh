@@ -0,0 +1,608 @@
+/*
+* d4
+* Copyright (C) 2020  Univ. Artois & CNRS
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef CORE_QueryServer_h
+#define CORE_QueryServer_h
+
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "../DAG/BinaryNNF.hh"
+#include "../utils/System.hh"
+#include "../utils/SolverTypes.hh"
+
+#define SERVER_BATCH_SIZE 64          // queries taken at once by a worker (one bit each for the SAT ones)
+#define SERVER_MAX_PENDING (1 << 16)  // queries read in advance, the readers wait beyond
+#define SERVER_MAX_UNSENT (1 << 24)   // bytes of answers a socket client has not read yet, it is dropped beyond
+#define SERVER_DRAIN_TIMEOUT 10       // seconds given to the clients to read their last answers when the server stops
+
+typedef std::chrono::steady_clock ServerClock;
+
+
+inline bool isServerCountMode(const char *mode)
+{
+  return !strcmp(mode, "EXACT") || !strcmp(mode, "DOUBLE") || !strcmp(mode, "LOG");
+}// isServerCountMode
+
+
+/**
+   Distribution of the latencies, with 8 buckets per power of 2 of
+   nanoseconds: a percentile is given within 9% whatever the number of
+   queries.
+ */
+class LatencyHistogram
+{
+  std::vector<uint64_t> count;
+  uint64_t nb;
+  double maxi;
+
+public:
+  LatencyHistogram() : count(8 * 48, 0), nb(0), maxi(0) {}
+
+  inline void add(double ns)
+  {
+    int b = (ns < 1) ? 0 : (int) (8 * log2(ns));
+    if(b >= (int) count.size()) b = count.size() - 1;
+    count[b]++;
+    nb++;
+    if(ns > maxi) maxi = ns;
+  }// add
+
+  void merge(const LatencyHistogram &h)
+  {
+    for(unsigned i = 0 ; i<count.size() ; i++) count[i] += h.count[i];
+    nb += h.nb;
+    if(h.maxi > maxi) maxi = h.maxi;
+  }// merge
+
+  /**
+     \return the upper bound (in ns) of the bucket of the p-th percentile
+   */
+  double percentile(double p)
+  {
+    if(!nb) return 0;
+    uint64_t rank = (uint64_t) ceil(p / 100 * nb), cumul = 0;
+    if(!rank) rank = 1;
+    for(unsigned b = 0 ; b<count.size() ; b++)
+      {
+        cumul += count[b];
+        if(cumul >= rank) return std::min(maxi, exp2((b + 1) / 8.0));
+      }
+    return maxi;
+  }// percentile
+
+  inline uint64_t getNb(){return nb;}
+  inline double getMax(){return maxi;}
+};
+
+
+/**
+   A client of the server: a Unix socket connection or the standard
+   input/output. The answers are written in the order of the queries,
+   by a writer of its own, so a client that does not read its answers
+   never blocks a worker.
+ */
+struct ServerConnection
+{
+  int in, out;
+  bool isSocket, broken, readDone;
+  uint64_t nbRead, nbWritten;
+
+  std::mutex lock;
+  std::condition_variable canWrite;
+  std::map<uint64_t, std::pair<std::string, ServerClock::time_point> > pending;
+  std::string ready;                                // the answers in order, not written yet
+  std::vector<ServerClock::time_point> readyReceived;
+
+  ServerConnection(int i, int o, bool s) : in(i), out(o), isSocket(s), broken(false), readDone(false), nbRead(0), nbWritten(0) {}
+  ~ServerConnection(){if(isSocket) close(in);}
+};
+
+
+struct ServerQuery
+{
+  std::shared_ptr<ServerConnection> conn;
+  uint64_t seq;
+  char type;                // 'm', 'd', or 'e' when the answer is known when it is read
+  std::vector<Lit> lits;
+  std::string answer;
+  ServerClock::time_point received;
+};
+
+
+/**
+   Answer the queries of runQueries ("m l1 ... ln 0" for the number of
+   models, "d l1 ... ln 0" for the satisfiability under the literals
+   l1 ... ln) on a binary d-DNNF, for a long time and for several
+   clients. Each line of a client gets one line in return: "s <value>",
+   "s SAT" or "s UNS", or "e <reason>" if the query is not valid. The
+   empty lines and the lines starting with 'c' are ignored, "q" stops
+   the server.
+
+   The queries of all the clients are put in one queue. Each worker
+   takes up to SERVER_BATCH_SIZE of them: the satisfiability ones are
+   decided in one pass on the d-DNNF, the counts are computed
+   incrementally (see BinaryNNF::buildIndex), or approximately with
+   BINARY_NNF_LANES of them in one pass (see BinaryNNFLanes).
+ */
+template<class T> class QueryServer
+{
+private:
+  BinaryNNFMapping &m;
+  BinaryNNFIndex<T> index;
+  int nbWorker, listenFd;
+  char countMode;  // 'E'xact (type T), 'D'ouble or 'L'og (BinaryNNFLanes)
+  const char *socketPath;
+
+  std::mutex lock;
+  std::condition_variable notEmpty, notFull, clientDone;
+  std::deque<ServerQuery> queue;
+  std::set<int> clients, writing;  // the sockets still read, still written
+  int nbReader, nbWriter;
+  bool stop, shutdownAsked;
+  LatencyHistogram latency;        // merged by the writers when they end
+
+  // one per worker
+  std::vector<uint64_t> nbCount, nbSat, nbError, nbBatch;
+  double timeIndex;
+
+  static bool writeAll(ServerConnection &c, const std::string &s)
+  {
+    size_t done = 0;
+    while(done < s.size())
+      {
+        ssize_t n = c.isSocket ? send(c.out, s.data() + done, s.size() - done, MSG_NOSIGNAL) :
+          write(c.out, s.data() + done, s.size() - done);
+        if(n < 0 && errno == EINTR) continue;
+        if(n <= 0) return false;
+        done += n;
+      }
+    return true;
+  }// writeAll
+
+  /**
+     Give the answer of a query to its connection, the answers which
+     are now in order are passed to its writer. A socket client which
+     lets more than SERVER_MAX_UNSENT bytes of answers wait is dropped.
+
+     @param[in] q, the answered query
+   */
+  void deliver(ServerQuery &q)
+  {
+    ServerConnection &c = *q.conn;
+    std::lock_guard<std::mutex> guard(c.lock);
+    c.pending[q.seq] = std::make_pair(std::move(q.answer), q.received);
+
+    std::map<uint64_t, std::pair<std::string, ServerClock::time_point> >::iterator it;
+    while((it = c.pending.begin()) != c.pending.end() && it->first == c.nbWritten)
+      {
+        if(!c.broken)
+          {
+            c.ready += it->second.first;
+            c.readyReceived.push_back(it->second.second);
+          }
+        c.pending.erase(it);
+        c.nbWritten++;
+      }
+
+    if(c.isSocket && !c.broken && c.ready.size() > SERVER_MAX_UNSENT)
+      {
+        c.broken = true;
+        c.ready.clear();
+        c.readyReceived.clear();
+        ::shutdown(c.out, SHUT_RDWR);  // its reader and its writer stop
+      }
+    c.canWrite.notify_all();
+  }// deliver
+
+  /**
+     Write the answers of a client as they come, until all its queries
+     are answered or it cannot be written anymore.
+   */
+  void writeAnswers(std::shared_ptr<ServerConnection> conn)
+  {
+    ServerConnection &c = *conn;
+    LatencyHistogram h;
+    std::string out;
+    std::vector<ServerClock::time_point> received;
+
+    std::unique_lock<std::mutex> guard(c.lock);
+    for(;;)
+      {
+        c.canWrite.wait(guard, [&c]{ return c.ready.size() || c.broken || (c.readDone && c.nbWritten == c.nbRead); });
+        if(c.broken || !c.ready.size()) break;
+
+        out.swap(c.ready);
+        received.swap(c.readyReceived);
+        guard.unlock();
+
+        bool ok = writeAll(c, out);
+        ServerClock::time_point now = ServerClock::now();
+        for(unsigned i = 0 ; ok && i<received.size() ; i++)
+          h.add(std::chrono::duration<double, std::nano>(now - received[i]).count());
+        out.clear();
+        received.clear();
+
+        guard.lock();
+        if(!ok) c.broken = true;
+      }
+    guard.unlock();
+
+    std::lock_guard<std::mutex> serverGuard(lock);
+    latency.merge(h);
+    if(c.isSocket) writing.erase(c.out);
+    nbWriter--;
+    clientDone.notify_all();
+  }// writeAnswers
+
+  /**
+     Parse a line given by a client.
+
+     \return false if the line asks to stop the server
+   */
+  bool parseLine(std::shared_ptr<ServerConnection> &conn, const char *p, const char *e,
+                 std::vector<ServerQuery> &read)
+  {
+    while(p < e && isspace(*p)) p++;
+    if(p == e || *p == 'c') return true;
+    if(*p == 'q') return false;
+
+    read.push_back(ServerQuery());
+    ServerQuery &q = read.back();
+    q.conn = conn;
+    q.seq = conn->nbRead++;
+    q.received = ServerClock::now();
+    q.type = *p++;
+
+    if(q.type != 'm' && q.type != 'd'){q.type = 'e'; q.answer = "e unknown query\n"; return true;}
+
+    for(;;)
+      {
+        while(p < e && isspace(*p)) p++;
+        if(p == e) break;
+
+        char *end;
+        long r = strtol(p, &end, 10);
+        if(end == p || end > e){q.type = 'e'; q.answer = "e malformed query\n"; return true;}
+        p = end;
+        if(!r) break;
+        if(labs(r) > (long) m.header->nbVar){q.type = 'e'; q.answer = "e variable out of range\n"; return true;}
+        q.lits.push_back(r > 0 ? mkLit(r - 1, false) : mkLit(-r - 1, true));
+      }
+
+    // a literal and its negation: nothing to compute
+    std::vector<Lit> sorted(q.lits);
+    std::sort(sorted.begin(), sorted.end());
+    for(unsigned i = 1 ; i<sorted.size() ; i++)
+      if(sorted[i] == ~sorted[i - 1])
+        {
+          q.answer = (q.type == 'm') ? "s 0\n" : "s UNS\n";
+          q.type = 'e';
+          break;
+        }
+
+    return true;
+  }// parseLine
+
+  /**
+     Read the queries of a client until the end of its input (or "q").
+   */
+  void readQueries(std::shared_ptr<ServerConnection> conn)
+  {
+    std::string buf;
+    std::vector<ServerQuery> read;
+    char chunk[1 << 16];
+    bool last = false, quit = false;
+
+    while(!last && !quit)
+      {
+        ssize_t n = ::read(conn->in, chunk, sizeof(chunk));
+        if(n < 0 && errno == EINTR) continue;
+        if(n > 0) buf.append(chunk, n);
+        else
+          {
+            last = true;
+            if(buf.size()) buf.push_back('\n');
+          }
+
+        size_t start = 0, nl;
+        while(!quit && (nl = buf.find('\n', start)) != std::string::npos)
+          {
+            quit = !parseLine(conn, buf.data() + start, buf.data() + nl, read);
+            start = nl + 1;
+          }
+        buf.erase(0, start);
+
+        if(read.size())
+          {
+            std::unique_lock<std::mutex> guard(lock);
+            notFull.wait(guard, [this]{ return queue.size() < SERVER_MAX_PENDING; });
+            for(unsigned i = 0 ; i<read.size() ; i++) queue.push_back(std::move(read[i]));
+            notEmpty.notify_all();
+          }
+        read.clear();
+      }
+
+    {
+      std::lock_guard<std::mutex> connGuard(conn->lock);
+      conn->readDone = true;
+      conn->canWrite.notify_all();
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+    if(conn->isSocket) clients.erase(conn->in);
+    if(quit && !shutdownAsked)
+      {
+        shutdownAsked = true;
+        if(listenFd >= 0) ::shutdown(listenFd, SHUT_RDWR);
+      }
+    nbReader--;
+    clientDone.notify_all();
+  }// readQueries
+
+  /**
+     The answer of an approximate count: the count itself, or in log
+     mode its logarithm written as a number in scientific notation.
+   */
+  static std::string approximateAnswer(double x, bool logMode)
+  {
+    char buf[64];
+    if(!logMode) snprintf(buf, sizeof(buf), "s %.17g\n", x);
+    else if(x == -HUGE_VAL) snprintf(buf, sizeof(buf), "s 0\n");
+    else
+      {
+        double e = floor(x / log(10.0)), mantissa = exp(x - e * log(10.0));
+        if(mantissa >= 10){mantissa /= 10; e++;}
+        snprintf(buf, sizeof(buf), "s %.15ge%+.0lf\n", mantissa, e);
+      }
+    return buf;
+  }// approximateAnswer
+
+  void runWorker(int id)
+  {
+    BinaryNNF<T> nnf(m);
+    nnf.setIndex(&index);
+    std::unique_ptr<BinaryNNFLanes> lanes;
+    if(countMode != 'E') lanes.reset(new BinaryNNFLanes(m, countMode == 'L'));
+
+    std::vector<ServerQuery> batch;
+    std::vector<std::vector<Lit> *> satQueries, countQueries;
+    std::vector<unsigned> satIdx, countIdx;
+    bool res[SERVER_BATCH_SIZE];
+    double counts[BINARY_NNF_LANES];
+
+    for(;;)
+      {
+        batch.clear();
+        {
+          std::unique_lock<std::mutex> guard(lock);
+          notEmpty.wait(guard, [this]{ return queue.size() || stop; });
+          if(!queue.size()) return;
+
+          while(queue.size() && batch.size() < SERVER_BATCH_SIZE)
+            {
+              batch.push_back(std::move(queue.front()));
+              queue.pop_front();
+            }
+          notFull.notify_all();
+        }
+
+        nbBatch[id]++;
+        satQueries.clear();
+        satIdx.clear();
+        countQueries.clear();
+        countIdx.clear();
+        for(unsigned i = 0 ; i<batch.size() ; i++)
+          {
+            ServerQuery &q = batch[i];
+            if(q.type == 'e') nbError[id]++;
+            else if(q.type == 'd'){satQueries.push_back(&q.lits); satIdx.push_back(i);}
+            else if(lanes){countQueries.push_back(&q.lits); countIdx.push_back(i);}
+            else
+              {
+                std::ostringstream os;
+                os << std::fixed << "s " << nnf.computeNbModelsConditioning(q.lits) << "\n";
+                q.answer = os.str();
+                nbCount[id]++;
+              }
+          }
+
+        for(unsigned i = 0 ; i<countQueries.size() ; i += BINARY_NNF_LANES)
+          {
+            int nb = std::min((int) (countQueries.size() - i), BINARY_NNF_LANES);
+            lanes->computeNbModelsConditioning(countQueries.data() + i, nb, counts);
+            for(int k = 0 ; k<nb ; k++) batch[countIdx[i + k]].answer = approximateAnswer(counts[k], countMode == 'L');
+            nbCount[id] += nb;
+          }
+
+        if(satQueries.size())
+          {
+            nnf.isSATConditioning(satQueries.data(), satQueries.size(), res);
+            for(unsigned i = 0 ; i<satIdx.size() ; i++) batch[satIdx[i]].answer = res[i] ? "s SAT\n" : "s UNS\n";
+            nbSat[id] += satQueries.size();
+          }
+
+        for(unsigned i = 0 ; i<batch.size() ; i++) deliver(batch[i]);
+      }
+  }// runWorker
+
+  /**
+     Create the Unix socket, a socket file left by a previous server is
+     replaced.
+   */
+  bool listenOn(const char *path)
+  {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if(strlen(path) >= sizeof(addr.sun_path)) return false;
+    strcpy(addr.sun_path, path);
+
+    struct stat st;
+    if(!stat(path, &st) && S_ISSOCK(st.st_mode)) unlink(path);
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(listenFd < 0) return false;
+    if(bind(listenFd, (struct sockaddr *) &addr, sizeof(addr)) || listen(listenFd, 64))
+      {
+        close(listenFd);
+        listenFd = -1;
+        return false;
+      }
+    socketPath = path;
+    return true;
+  }// listenOn
+
+  void printStatistics(double wallTime)
+  {
+    uint64_t count = 0, sat = 0, error = 0, batches = 0;
+    for(int i = 0 ; i<nbWorker ; i++)
+      {
+        count += nbCount[i];
+        sat += nbSat[i];
+        error += nbError[i];
+        batches += nbBatch[i];
+      }
+
+    uint64_t nb = count + sat + error;
+    printf("c Query server: %lu queries (%lu counts, %lu SAT, %lu answered when read) in %lu batches\n",
+           (unsigned long) nb, (unsigned long) count, (unsigned long) sat, (unsigned long) error,
+           (unsigned long) batches);
+    printf("c Query server: %.3lf s, %.0lf queries/s, %.1lf queries per batch, index built in %.3lf s\n",
+           wallTime, wallTime > 0 ? nb / wallTime : 0, batches ? (double) nb / batches : 0, timeIndex);
+    printf("c Query latency (us): p50 %.1lf, p90 %.1lf, p99 %.1lf, p99.9 %.1lf, max %.1lf\n",
+           latency.percentile(50) / 1000, latency.percentile(90) / 1000, latency.percentile(99) / 1000,
+           latency.percentile(99.9) / 1000, latency.getMax() / 1000);
+  }// printStatistics
+
+public:
+  /**
+     Constructor.
+
+     @param[in] _m, the mapped d-DNNF
+     @param[in] _nbWorker, the number of workers
+     @param[in] _countMode, how the counts are computed: EXACT, DOUBLE or LOG
+   */
+  QueryServer(BinaryNNFMapping &_m, int _nbWorker, const char *_countMode) :
+    m(_m), nbWorker(_nbWorker), listenFd(-1), countMode(_countMode[0]), socketPath(NULL), nbReader(0), nbWriter(0), stop(false),
+    shutdownAsked(false), nbCount(_nbWorker, 0), nbSat(_nbWorker, 0), nbError(_nbWorker, 0), nbBatch(_nbWorker, 0)
+  {
+    double start = cpuTime();
+    BinaryNNF<T> nnf(m);
+    nnf.buildIndex(index);
+    timeIndex = cpuTime() - start;
+  }// constructor
+
+  /**
+     Answer the queries until the end of the standard input, or until
+     "q" is received.
+
+     @param[in] where, "-" for the standard input/output, the path of a Unix socket otherwise
+     \return false if the socket cannot be created
+   */
+  bool serve(const char *where)
+  {
+    bool isPipe = !strcmp(where, "-");
+    if(!isPipe && !listenOn(where)) return false;
+
+    signal(SIGPIPE, SIG_IGN);
+    if(!isPipe) printf("c Query server listening on %s\n", where);
+    fflush(stdout);
+
+    ServerClock::time_point start = ServerClock::now();
+    std::vector<std::thread> workers;
+    for(int i = 0 ; i<nbWorker ; i++) workers.push_back(std::thread(&QueryServer<T>::runWorker, this, i));
+
+    if(isPipe)
+      {
+        std::shared_ptr<ServerConnection> conn = std::make_shared<ServerConnection>(0, 1, false);
+        nbReader = nbWriter = 1;
+        std::thread(&QueryServer<T>::writeAnswers, this, conn).detach();
+        readQueries(conn);
+      }
+    else
+      {
+        for(;;)
+          {
+            int fd = accept(listenFd, NULL, NULL);
+            if(fd < 0 && (errno == EINTR || errno == ECONNABORTED)) continue;
+            if(fd < 0) break;
+
+            std::lock_guard<std::mutex> guard(lock);
+            if(shutdownAsked){close(fd); break;}
+            clients.insert(fd);
+            writing.insert(fd);
+            nbReader++;
+            nbWriter++;
+            std::shared_ptr<ServerConnection> conn = std::make_shared<ServerConnection>(fd, fd, true);
+            std::thread(&QueryServer<T>::writeAnswers, this, conn).detach();
+            std::thread(&QueryServer<T>::readQueries, this, conn).detach();
+          }
+
+        // the clients still connected are not read anymore, their pending queries are answered
+        std::unique_lock<std::mutex> guard(lock);
+        for(std::set<int>::iterator it = clients.begin() ; it != clients.end() ; it++) ::shutdown(*it, SHUT_RD);
+        clientDone.wait(guard, [this]{ return !nbReader; });
+        close(listenFd);
+        unlink(socketPath);
+      }
+
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      stop = true;
+    }
+    notEmpty.notify_all();
+    for(unsigned i = 0 ; i<workers.size() ; i++) workers[i].join();
+
+    // every query is answered, the clients which do not read their last answers are dropped
+    {
+      std::unique_lock<std::mutex> guard(lock);
+      if(!clientDone.wait_for(guard, std::chrono::seconds(SERVER_DRAIN_TIMEOUT), [this]{ return !nbWriter; }))
+        {
+          for(std::set<int>::iterator it = writing.begin() ; it != writing.end() ; it++) ::shutdown(*it, SHUT_RDWR);
+          clientDone.wait(guard, [this]{ return !nbWriter; });
+        }
+    }
+
+    printStatistics(std::chrono::duration<double>(ServerClock::now() - start).count());
+    return true;
+  }// serve
+};
+
+#endif
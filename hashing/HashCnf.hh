@@ -19,57 +19,89 @@
 #define HASHING_HASHCNF
 
 
+#include <cstdint>
+
 class HashCnf
 {
 public:
-  inline unsigned hash(char *key, unsigned len)
+  /**
+     64-bit murmur hash of the key (MurmurHash64A). The whole value is
+     kept by the cache as the fingerprint of the formula.
+
+     @param[in] key, the data
+     @param[in] len, the number of bytes of key
+     \return the hash value
+   */
+  inline uint64_t hash(char *key, unsigned len)
   {
     // 'm' and 'r' are mixing constants generated offline.  They're not really
     // 'magic', they just happen to work well.
-    const unsigned int m = 0x5bd1e995;
-    const int r = 24;
+    const uint64_t m = 0xc6a4a7935bd1e995ULL;
+    const int r = 47;
 
     // Initialize the hash to a 'random' value
-    unsigned int h = 0x29111983 ^ len;
+    uint64_t h = 0x29111983ULL ^ (len * m);
 
-    // Mix 4 bytes at a time into the hash
+    // Mix 8 bytes at a time into the hash
     const unsigned char * data = (const unsigned char *)key;
 
-    while(len >= 4)
+    while(len >= 8)
     {
-      unsigned int k = *(unsigned int *)data;
+      uint64_t k = *(uint64_t *)data;
 
       k *= m;
       k ^= k >> r;
       k *= m;
 
-      h *= m;
       h ^= k;
+      h *= m;
 
-      data += 4;
-      len -= 4;
+      data += 8;
+      len -= 8;
     }
 
     // Handle the last few bytes of the input array
     switch(len)
     {
-      case 3: h ^= data[2] << 16;
-      case 2: h ^= data[1] << 8;
-      case 1: h ^= data[0];
+      case 7: h ^= (uint64_t) data[6] << 48;
+      case 6: h ^= (uint64_t) data[5] << 40;
+      case 5: h ^= (uint64_t) data[4] << 32;
+      case 4: h ^= (uint64_t) data[3] << 24;
+      case 3: h ^= (uint64_t) data[2] << 16;
+      case 2: h ^= (uint64_t) data[1] << 8;
+      case 1: h ^= (uint64_t) data[0];
         h *= m;
     };
 
     // Do a few final mixes of the hash to ensure the last few bytes are
     // well-incorporated.
-    h ^= h >> 13;
+    h ^= h >> r;
     h *= m;
-    h ^= h >> 15;
+    h ^= h >> r;
 
     return h;
 
   }// hash
 
 
+  /**
+     Zobrist keys used to maintain the signatures of the components
+     incrementally (see BucketManager::computeSignature): a literal and
+     a variable get a pseudo random value (splitmix64, so the values do
+     not depend on the run), a clause is summarized by the xor of the
+     keys of its unassigned literals.
+   */
+  static inline uint64_t zobristMix(uint64_t x)
+  {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+  }// zobristMix
+
+  static inline uint64_t zobristLit(int idxLit){return zobristMix(((uint64_t) idxLit << 1) | 1);}
+  static inline uint64_t zobristVar(int v){return zobristMix((uint64_t) v << 1);}
+  static inline uint64_t zobristClause(uint64_t residual){return zobristMix(residual ^ 0x29111983ULL);}
 };
 
 #endif
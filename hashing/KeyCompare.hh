@@ -0,0 +1,148 @@
+/*
+* d4
+* Copyright (C) 2020  Univ. Artois & CNRS
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef HASHING_KEYCOMPARE
+#define HASHING_KEYCOMPARE
+
+#include <string.h>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define KEY_COMPARE_X86
+#endif
+
+
+/**
+   Equality test of two cache keys (the bytes built by
+   BucketManager::storeFormula). Only the equality is needed, then the
+   vectorised variants stop at the first differing block instead of
+   looking for the first differing byte as memcmp does.
+
+   The variant is chosen at the first call w.r.t. the CPU the binary
+   runs on (AVX2, then SSE2, then 8 bytes at a time), so the binary
+   does not have to be compiled with -mavx2.
+ */
+class KeyCompare
+{
+public:
+  typedef bool (*EqualFunction)(const char *a, const char *b, unsigned len);
+
+  static inline uint64_t load64(const char *p){uint64_t x; memcpy(&x, p, 8); return x;}
+  static inline uint32_t load32(const char *p){uint32_t x; memcpy(&x, p, 4); return x;}
+
+  /**
+     The keys of less than 16 bytes are compared with two overlapping
+     loads, without a loop.
+   */
+  static inline bool equalShort(const char *a, const char *b, unsigned len)
+  {
+    if(len >= 8) return !((load64(a) ^ load64(b)) | (load64(a + len - 8) ^ load64(b + len - 8)));
+    if(len >= 4) return !((load32(a) ^ load32(b)) | (load32(a + len - 4) ^ load32(b + len - 4)));
+    for(unsigned i = 0 ; i<len ; i++) if(a[i] != b[i]) return false;
+    return true;
+  }// equalShort
+
+  static bool equalScalar(const char *a, const char *b, unsigned len)
+  {
+    if(len < 16) return equalShort(a, b, len);
+
+    const char *endA = a + len - 8, *endB = b + len - 8;
+    for( ; a < endA ; a += 8, b += 8) if(load64(a) != load64(b)) return false;
+    return load64(endA) == load64(endB);
+  }// equalScalar
+
+#ifdef KEY_COMPARE_X86
+  static inline bool equal16(const char *a, const char *b)
+  {
+    __m128i x = _mm_loadu_si128((const __m128i *) a), y = _mm_loadu_si128((const __m128i *) b);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) == 0xFFFF;
+  }
+
+  static bool equalSse2(const char *a, const char *b, unsigned len)
+  {
+    if(len < 16) return equalShort(a, b, len);
+
+    const char *endA = a + len - 16, *endB = b + len - 16;
+    for( ; a < endA ; a += 16, b += 16) if(!equal16(a, b)) return false;
+    return equal16(endA, endB);
+  }// equalSse2
+
+  __attribute__((target("avx2"))) static inline __m256i diff32(const char *a, const char *b)
+  {
+    return _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) a), _mm256_loadu_si256((const __m256i *) b));
+  }
+
+  __attribute__((target("avx2"))) static bool equalAvx2(const char *a, const char *b, unsigned len)
+  {
+    if(len < 16) return equalShort(a, b, len);
+    if(len <= 32) return equal16(a, b) && equal16(a + len - 16, b + len - 16);
+
+    const char *endA = a + len - 32, *endB = b + len - 32;
+    for( ; a + 32 < endA ; a += 64, b += 64)
+    {
+      __m256i d = _mm256_or_si256(diff32(a, b), diff32(a + 32, b + 32));
+      if(!_mm256_testz_si256(d, d)) return false;
+    }
+
+    __m256i d = a < endA ? _mm256_or_si256(diff32(a, b), diff32(endA, endB)) : diff32(endA, endB);
+    return _mm256_testz_si256(d, d);
+  }// equalAvx2
+#endif
+
+  static bool equalMemcmp(const char *a, const char *b, unsigned len){return !memcmp(a, b, len);}
+
+
+  /**
+     Select the fastest variant available on the current CPU.
+   */
+  static EqualFunction selectEqual()
+  {
+#ifdef KEY_COMPARE_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")) return equalAvx2;
+    if(__builtin_cpu_supports("sse2")) return equalSse2;
+#endif
+    return equalScalar;
+  }// selectEqual
+
+  static const char *nameEqual(EqualFunction f)
+  {
+#ifdef KEY_COMPARE_X86
+    if(f == equalAvx2) return "AVX2";
+    if(f == equalSse2) return "SSE2";
+#endif
+    if(f == equalMemcmp) return "memcmp";
+    return "scalar";
+  }// nameEqual
+
+
+  /**
+     Test if the two keys are identical.
+
+     @param[in] a, b, the keys
+     @param[in] len, their number of bytes
+     \return true if the len first bytes of a and b are the same
+   */
+  static inline bool equal(const char *a, const char *b, unsigned len)
+  {
+    static const EqualFunction f = selectEqual();
+    return f(a, b, len);
+  }// equal
+};
+
+#endif
@@ -23,7 +23,6 @@
 #include "../interfaces/PartitionerInterface.hh"
 #include "../heuristics/ClauseBipartiteGraphPartitioner.hh"
 
-#include "../patoh/patoh.h"
 #include "../utils/equiv.hh"
 
 using namespace std;
@@ -39,7 +38,6 @@ void ClauseBipartiteGraphPartitioner::computePartition(vec<Var> &component, vec<
                                                        vec<int> &cutVar, ScoringMethod *sm)
 {
   adjustStructureWrTClauses();
-  int cut;
   cutVar.clear();
 
   vec< vec<int> > occMap;
@@ -136,22 +134,12 @@ void ClauseBipartiteGraphPartitioner::computePartition(vec<Var> &component, vec<
   xpins[vUse.size()] = posPins;
 
   // hypergraph partitioner
-  PaToH_Parameters args;
-  if(vUse.size() < 200) PaToH_Initialize_Parameters(&args, PATOH_CONPART, PATOH_SUGPARAM_DEFAULT);
-  else PaToH_Initialize_Parameters(&args, PATOH_CONPART, PATOH_SUGPARAM_QUALITY);
-
-  args._k = 2;
-  args.seed = 1;
-
   for(int i = 0 ; i<idxClauses.size() ; i++) cwghts[i] = weightClause[idxClauses[i]];
-  PaToH_Alloc(&args, idxClauses.size(), vUse.size(), 1, cwghts, NULL, xpins, pins);
-  PaToH_Part(&args, idxClauses.size(), vUse.size(), 1, 0, cwghts, NULL, xpins, pins,
-             NULL, partvec, partweights, &cut);
+  bisectHypergraph(idxClauses.size(), vUse.size(), cwghts, xpins, pins, partvec, partweights, vUse.size() >= 200);
 
   extractCutFromClauses(occMap, vUse, cutVar);
   for(int i = 0 ; i<component.size() ; i++)
     useLessVariable[component[i]] = inCurrentComponent[component[i]] = false;
-  PaToH_Free();
 
   for(int i = 0 ; i<equivVar.size() ; i++)
   {
@@ -178,7 +166,7 @@ void ClauseBipartiteGraphPartitioner::computeUselessClauses(vec<int> &idxClauses
   for(int i = 0 ; i<idxClauses.size() ; i++)
     {
       if(idxClauses[i] == -1) continue;
-      vec<Lit> &c = om->getClause(idxClauses[i]);
+      VecView<Lit> c = om->getClause(idxClauses[i]);
       for(int j = 0 ; j<c.size() ; j++) markedVar[var(c[j])] = true;          // we mark the clause
 
       // search a variable in c that minimized the number of occurrences
@@ -200,7 +188,7 @@ void ClauseBipartiteGraphPartitioner::computeUselessClauses(vec<int> &idxClauses
             {
               int idxCl = occMap[mapVar[v]][j];
               if(idxCl == i || idxClauses[idxCl] == -1) continue;
-              vec<Lit> &d = om->getClause(idxClauses[idxCl]);
+              VecView<Lit> d = om->getClause(idxClauses[idxCl]);
 
               int cpt = 0;
               for(int k = 0 ; cpt < nbAvailableVar && k<d.size() ; k++)
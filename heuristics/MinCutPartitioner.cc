@@ -45,7 +45,7 @@ void MinCutPartition::minCut(vec<Var> &component)
   vec<int> idxClauses;
   for(int i = 0 ; i<om->getNbClause() ; i++)
     {
-      vec<Lit> &c = om->getClause(i);
+      VecView<Lit> c = om->getClause(i);
       if(om->isSatisfiedClause(i)) continue;
       if(!inCurrentComponent[var(c[0])]) continue;
       idxClauses.push(i);
@@ -56,12 +56,12 @@ void MinCutPartition::minCut(vec<Var> &component)
   vec<edge_t> vecEdges;
   for(int i = 0 ; i<idxClauses.size() ; i++)
     {
-      vec<Lit> &c = om->getClause(idxClauses[i]);
+      VecView<Lit> c = om->getClause(idxClauses[i]);
       for(int j = 0 ; j<c.size() ; j++) markedVar[var(c[j])] = true;
 
       for(int j = i + 1 ; j<idxClauses.size() ; j++)
         {
-          vec<Lit> &d = om->getClause(idxClauses[j]);
+          VecView<Lit> d = om->getClause(idxClauses[j]);
           bool intersect = false;
           for(int k = 0 ; !intersect && k<d.size() ; k++) intersect = markedVar[var(d[k])];
           if(intersect) vecEdges.push({i, j});
@@ -0,0 +1,477 @@
+/*
+* d4
+* Copyright (C) 2020  Univ. Artois & CNRS
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <climits>
+#include <cassert>
+
+#include "../heuristics/MultilevelBisection.hh"
+
+/**
+   Constructor.
+
+   @param[in] _imbalance, the weight of a part is at most (1 + _imbalance) times the half of the total weight
+ */
+MultilevelBisection::MultilevelBisection(double _imbalance) :
+  imbalance(_imbalance), seed(1), heap0(GainLt(gain)), heap1(GainLt(gain))
+{
+}// constructor
+
+
+/**
+   Build the nets of each cell from the cells of each net.
+
+   @param[in,out] l, the level
+ */
+void MultilevelBisection::buildCellNets(Level &l)
+{
+  l.xnets.clear();
+  l.xnets.growTo(l.nbCell + 1, 0);
+  for(int i = 0 ; i<l.pins.size() ; i++) l.xnets[l.pins[i] + 1]++;
+  for(int i = 0 ; i<l.nbCell ; i++) l.xnets[i + 1] += l.xnets[i];
+
+  l.nets.clear();
+  l.nets.growTo(l.pins.size());
+  mark.clear();
+  l.xnets.copyTo(mark);
+  for(int n = 0 ; n<l.nbNet ; n++)
+    for(int i = l.xpins[n] ; i<l.xpins[n + 1] ; i++) l.nets[mark[l.pins[i]]++] = n;
+}// buildCellNets
+
+
+/**
+   Build the next level: each cell is matched with the unmatched
+   neighbour with which it shares the most nets (weighted by the
+   inverse of the size of the nets).
+
+   @param[in] fine, the current level
+   @param[out] coarse, the next level
+   \return false if the hypergraph does not shrink enough to go on
+ */
+bool MultilevelBisection::coarsen(Level &fine, Level &coarse)
+{
+  int n = fine.nbCell;
+  order.clear();
+  for(int i = 0 ; i<n ; i++) order.push(i);
+  for(int i = n - 1 ; i>0 ; i--)
+    {
+      int j = nextRandom() % (i + 1);
+      int tmp = order[i]; order[i] = order[j]; order[j] = tmp;
+    }
+
+  fine.coarseOf.clear();
+  fine.coarseOf.growTo(n, -1);
+  score.growTo(n, 0);
+
+  int maxWeight = totalWeight / (ML_COARSEST_SIZE / 2);
+  if(maxWeight < 1) maxWeight = 1;
+
+  vec<int> &touched = moves;
+  int nbCoarse = 0;
+  for(int i = 0 ; i<n ; i++)
+    {
+      int u = order[i];
+      if(fine.coarseOf[u] != -1) continue;
+
+      touched.clear();
+      for(int k = fine.xnets[u] ; k<fine.xnets[u + 1] ; k++)
+        {
+          int net = fine.nets[k], size = fine.xpins[net + 1] - fine.xpins[net];
+          if(size > ML_MAX_NET_MATCH) continue;
+
+          double w = 1.0 / (size - 1);
+          for(int j = fine.xpins[net] ; j<fine.xpins[net + 1] ; j++)
+            {
+              int v = fine.pins[j];
+              if(v == u || fine.coarseOf[v] != -1 || fine.cellWeight[u] + fine.cellWeight[v] > maxWeight) continue;
+              if(score[v] == 0) touched.push(v);
+              score[v] += w;
+            }
+        }
+
+      int best = -1;
+      for(int j = 0 ; j<touched.size() ; j++)
+        {
+          if(best == -1 || score[touched[j]] > score[best]) best = touched[j];
+          score[touched[j]] = 0;
+        }
+
+      fine.coarseOf[u] = nbCoarse;
+      if(best != -1) fine.coarseOf[best] = nbCoarse;
+      nbCoarse++;
+    }
+  if(nbCoarse > n - n / 10) return false;
+
+  coarse.nbCell = nbCoarse;
+  coarse.cellWeight.clear();
+  coarse.cellWeight.growTo(nbCoarse, 0);
+  for(int i = 0 ; i<n ; i++) coarse.cellWeight[fine.coarseOf[i]] += fine.cellWeight[i];
+
+  // the nets with one pin left cannot be cut: they are removed
+  mark.clear();
+  mark.growTo(nbCoarse, -1);
+  coarse.xpins.clear();
+  coarse.pins.clear();
+  coarse.xpins.push(0);
+  for(int net = 0 ; net<fine.nbNet ; net++)
+    {
+      int start = coarse.pins.size();
+      for(int j = fine.xpins[net] ; j<fine.xpins[net + 1] ; j++)
+        {
+          int c = fine.coarseOf[fine.pins[j]];
+          if(mark[c] != net){mark[c] = net; coarse.pins.push(c);}
+        }
+
+      if(coarse.pins.size() - start < 2) coarse.pins.shrink_(coarse.pins.size() - start);
+      else coarse.xpins.push(coarse.pins.size());
+    }
+  coarse.nbNet = coarse.xpins.size() - 1;
+
+  buildCellNets(coarse);
+  return true;
+}// coarsen
+
+
+/**
+   Compute the number of cells of each net in each part, and the gain
+   of moving each cell to the other part (the decrease of the cut).
+
+   @param[in] l, the level
+ */
+void MultilevelBisection::computeGains(Level &l)
+{
+  pinCount.clear();
+  pinCount.growTo(l.nbNet << 1, 0);
+  for(int net = 0 ; net<l.nbNet ; net++)
+    for(int j = l.xpins[net] ; j<l.xpins[net + 1] ; j++) pinCount[(net << 1) | part[l.pins[j]]]++;
+
+  gain.clear();
+  gain.growTo(l.nbCell, 0);
+  for(int u = 0 ; u<l.nbCell ; u++)
+    for(int k = l.xnets[u] ; k<l.xnets[u + 1] ; k++)
+      {
+        int *pc = &pinCount[l.nets[k] << 1];
+        if(pc[part[u]] == 1) gain[u]++;
+        if(!pc[1 - part[u]]) gain[u]--;
+      }
+}// computeGains
+
+
+/**
+   \return the number of nets with cells in the two parts
+ */
+int MultilevelBisection::computeCut(Level &l)
+{
+  int cut = 0;
+  for(int net = 0 ; net<l.nbNet ; net++)
+    {
+      if(l.xpins[net] == l.xpins[net + 1]) continue;
+      int p = part[l.pins[l.xpins[net]]];
+      for(int j = l.xpins[net] + 1 ; j<l.xpins[net + 1] ; j++)
+        if(part[l.pins[j]] != p){cut++; break;}
+    }
+  return cut;
+}// computeCut
+
+
+/**
+   \return true if the cell has a cut net (the other cells are only
+   put in the heaps when the gain of one of their nets changes)
+ */
+bool MultilevelBisection::isBoundary(Level &l, int u)
+{
+  for(int k = l.xnets[u] ; k<l.xnets[u + 1] ; k++)
+    {
+      int *pc = &pinCount[l.nets[k] << 1];
+      if(pc[0] && pc[1]) return true;
+    }
+  return false;
+}// isBoundary
+
+
+/**
+   Move a cell to the other part.
+
+   @param[in] l, the level
+   @param[in] u, the cell
+   @param[in] updateGain, update the gains of the unlocked cells (and their place in the heaps)
+ */
+void MultilevelBisection::moveCell(Level &l, int u, bool updateGain)
+{
+  int from = part[u], to = 1 - from;
+
+  for(int k = l.xnets[u] ; k<l.xnets[u + 1] ; k++)
+    {
+      int net = l.nets[k];
+      int *pc = &pinCount[net << 1];
+      int *first = &l.pins[l.xpins[net]], *last = &l.pins[l.xpins[net + 1]];
+
+      if(updateGain)
+        {
+          if(!pc[to])
+            {
+              for(int *p = first ; p != last ; p++)
+                if(!locked[*p]){gain[*p]++; (part[*p] ? heap1 : heap0).update(*p);}
+            }
+          else if(pc[to] == 1)
+            {
+              for(int *p = first ; p != last ; p++)
+                if(part[*p] == to)
+                  {
+                    if(!locked[*p]){gain[*p]--; (part[*p] ? heap1 : heap0).update(*p);}
+                    break;
+                  }
+            }
+        }
+
+      pc[from]--;
+      pc[to]++;
+
+      if(updateGain)
+        {
+          if(!pc[from])
+            {
+              for(int *p = first ; p != last ; p++)
+                if(!locked[*p]){gain[*p]--; (part[*p] ? heap1 : heap0).update(*p);}
+            }
+          else if(pc[from] == 1)
+            {
+              for(int *p = first ; p != last ; p++)
+                if(*p != u && part[*p] == from)
+                  {
+                    if(!locked[*p]){gain[*p]++; (part[*p] ? heap1 : heap0).update(*p);}
+                    break;
+                  }
+            }
+        }
+    }
+
+  part[u] = to;
+  partWeight[from] -= l.cellWeight[u];
+  partWeight[to] += l.cellWeight[u];
+}// moveCell
+
+
+/**
+   Fiduccia-Mattheyses refinement: each pass moves every cell at most
+   once, the best one first (among the moves that do not make the
+   balance worse), and keeps the best prefix of the moves. A better
+   balance is preferred to a smaller cut.
+
+   @param[in] l, the level, part is its partition
+   @param[in] cut, the current cut
+   \return the cut after the refinement
+ */
+int MultilevelBisection::refine(Level &l, int cut)
+{
+  int stall = l.nbCell / 8;
+  if(stall < ML_MIN_STALL) stall = ML_MIN_STALL;
+
+  for(int pass = 0 ; pass<ML_MAX_PASS ; pass++)
+    {
+      computeGains(l);
+      heap0.clear();
+      heap1.clear();
+      locked.clear();
+      locked.growTo(l.nbCell, false);
+      for(int u = 0 ; u<l.nbCell ; u++)
+        if(isBoundary(l, u)) (part[u] ? heap1 : heap0).insert(u);
+
+      moves.clear();
+      int bestPos = 0, bestCut = cut, bestPen = penalty(), curCut = cut;
+      for(;;)
+        {
+          int pen = penalty(), cand = -1;
+          for(int s = 0 ; s<2 ; s++)
+            {
+              Heap<GainLt> &h = s ? heap1 : heap0;
+              if(h.empty()) continue;
+
+              int u = h[0], w = l.cellWeight[u];
+              int pf = partWeight[s] - w, pt = partWeight[1 - s] + w;
+              if((pf > bound ? pf - bound : 0) + (pt > bound ? pt - bound : 0) > pen) continue;
+
+              if(cand == -1 || gain[u] > gain[cand] ||
+                 (gain[u] == gain[cand] && partWeight[s] > partWeight[part[cand]])) cand = u;
+            }
+          if(cand == -1) break;
+
+          (part[cand] ? heap1 : heap0).removeMin();
+          locked[cand] = true;
+          curCut -= gain[cand];
+          moveCell(l, cand, true);
+          moves.push(cand);
+
+          pen = penalty();
+          if(pen < bestPen || (pen == bestPen && curCut < bestCut))
+            {
+              bestPen = pen;
+              bestCut = curCut;
+              bestPos = moves.size();
+            }
+          else if(moves.size() - bestPos > stall) break;
+        }
+
+      for(int i = moves.size() - 1 ; i>=bestPos ; i--) moveCell(l, moves[i], false);
+      cut = bestCut;
+      if(!bestPos) break;
+    }
+
+  assert(cut == computeCut(l));
+  return cut;
+}// refine
+
+
+/**
+   Compute the partition of the coarsest level: a part is grown from a
+   random cell by adding the cell that increases the cut the less,
+   until it has half of the weight, then the partition is refined. The
+   best of ML_NB_INIT tries is kept.
+
+   @param[in] l, the coarsest level
+   \return the cut
+ */
+int MultilevelBisection::initPartition(Level &l)
+{
+  int bestCut = INT_MAX, bestPen = INT_MAX;
+  for(int t = 0 ; t<ML_NB_INIT ; t++)
+    {
+      part.clear();
+      part.growTo(l.nbCell, 0);
+      partWeight[0] = totalWeight;
+      partWeight[1] = 0;
+
+      computeGains(l);
+      heap0.clear();
+      heap1.clear();
+      locked.clear();
+      locked.growTo(l.nbCell, false);
+      for(int u = 0 ; u<l.nbCell ; u++) heap0.insert(u);
+
+      int u = nextRandom() % l.nbCell;
+      while(partWeight[1] < totalWeight / 2)
+        {
+          locked[u] = true;
+          moveCell(l, u, true);
+
+          while(!heap0.empty() && locked[heap0[0]]) heap0.removeMin();
+          if(heap0.empty()) break;
+          u = heap0[0];
+          if(partWeight[1] + l.cellWeight[u] > bound) break;
+        }
+
+      int cut = refine(l, computeCut(l)), pen = penalty();
+      if(pen < bestPen || (pen == bestPen && cut < bestCut))
+        {
+          bestPen = pen;
+          bestCut = cut;
+          part.copyTo(bestPart);
+        }
+    }
+
+  bestPart.copyTo(part);
+  partWeight[0] = partWeight[1] = 0;
+  for(int u = 0 ; u<l.nbCell ; u++) partWeight[part[u]] += l.cellWeight[u];
+  return bestCut;
+}// initPartition
+
+
+/**
+   Split the cells of a hypergraph in two parts (the same arguments as
+   PaToH_Part, with one constraint and unit net costs).
+
+   @param[in] nbCell, nbNet, the size of the hypergraph
+   @param[in] cellWeight, the weight of the cells
+   @param[in] xpins, pins, the cells of the net i are pins[xpins[i]], ..., pins[xpins[i + 1] - 1]
+   @param[out] partvec, the part (0 or 1) of each cell
+   @param[out] partweights, the weight of each part
+   @param[in] nbRun, the number of multilevel runs (with other matchings), the best one is returned
+   \return the number of cut nets
+ */
+int MultilevelBisection::bisect(int nbCell, int nbNet, const int *cellWeight, const int *xpins, const int *pins,
+                                int *partvec, int *partweights, int nbRun)
+{
+  seed = 0x9E3779B97F4A7C15ULL;
+  if(!levels.size()) levels.emplace_back();
+
+  Level &l0 = levels[0];
+  l0.nbCell = nbCell;
+  l0.nbNet = nbNet;
+  l0.cellWeight.clear();
+  l0.xpins.clear();
+  l0.pins.clear();
+  totalWeight = 0;
+  for(int i = 0 ; i<nbCell ; i++){l0.cellWeight.push(cellWeight[i]); totalWeight += cellWeight[i];}
+  for(int i = 0 ; i<=nbNet ; i++) l0.xpins.push(xpins[i]);
+  for(int i = 0 ; i<xpins[nbNet] ; i++) l0.pins.push(pins[i]);
+  buildCellNets(l0);
+
+  if(nbCell < 2)
+    {
+      for(int i = 0 ; i<nbCell ; i++) partvec[i] = 0;
+      partweights[0] = totalWeight;
+      partweights[1] = 0;
+      return 0;
+    }
+
+  // the coarse levels accept one more cell in a part, the finest one
+  // has to satisfy the imbalance
+  int finalBound = (int) (totalWeight * (1 + imbalance) / 2);
+  if(finalBound < (totalWeight + 1) / 2) finalBound = (totalWeight + 1) / 2;
+
+  int bestCut = INT_MAX, bestPen = INT_MAX;
+  for(int run = 0 ; run<nbRun ; run++)
+    {
+      int nbLevel = 1;
+      while(levels[nbLevel - 1].nbCell > ML_COARSEST_SIZE)
+        {
+          if((int) levels.size() == nbLevel) levels.emplace_back();
+          if(!coarsen(levels[nbLevel - 1], levels[nbLevel])) break;
+          nbLevel++;
+        }
+
+      int cut = 0;
+      for(int i = nbLevel - 1 ; i>=0 ; i--)
+        {
+          Level &l = levels[i];
+          int maxWeight = 0;
+          for(int u = 0 ; u<l.nbCell ; u++) if(l.cellWeight[u] > maxWeight) maxWeight = l.cellWeight[u];
+          bound = i ? (totalWeight + 1) / 2 + maxWeight : finalBound;
+          if(bound < finalBound) bound = finalBound;
+
+          if(i == nbLevel - 1) cut = initPartition(l);
+          else
+            {
+              bestPart.clear();
+              for(int u = 0 ; u<l.nbCell ; u++) bestPart.push(part[l.coarseOf[u]]);
+              bestPart.copyTo(part);
+              cut = refine(l, computeCut(l));
+            }
+        }
+
+      int pen = penalty();
+      if(pen < bestPen || (pen == bestPen && cut < bestCut))
+        {
+          bestPen = pen;
+          bestCut = cut;
+          for(int i = 0 ; i<nbCell ; i++) partvec[i] = part[i];
+          partweights[0] = partWeight[0];
+          partweights[1] = partWeight[1];
+        }
+    }
+
+  return bestCut;
+}// bisect
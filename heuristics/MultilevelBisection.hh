@@ -0,0 +1,107 @@
+/*
+* d4
+* Copyright (C) 2020  Univ. Artois & CNRS
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef HEURISTICS_MULTILEVEL_BISECTION
+#define HEURISTICS_MULTILEVEL_BISECTION
+
+#include <cstdint>
+#include <deque>
+
+#include "../mtl/Vec.hh"
+#include "../mtl/Heap.hh"
+
+#define ML_COARSEST_SIZE 100  // the coarsening stops under this number of cells
+#define ML_MAX_NET_MATCH 64   // the nets with more pins are not used to match the cells
+#define ML_NB_INIT 8          // number of initial partitions tried on the coarsest hypergraph
+#define ML_MAX_PASS 8         // number of FM passes per level
+#define ML_MIN_STALL 50       // an FM pass stops after max(ML_MIN_STALL, nbCell/8) moves without gain
+#define ML_NB_RUN_QUALITY 2   // number of multilevel runs when the quality is preferred to the speed
+
+
+/**
+   Multilevel bisection of a hypergraph which minimizes the number of
+   cut nets (the same problem PaToH solves with PATOH_CONPART and
+   k = 2):
+
+   - coarsening: the cells are matched with the neighbour that shares
+     the most nets with them (heavy connectivity matching), until the
+     hypergraph has less than ML_COARSEST_SIZE cells;
+   - initial partition: greedy growing of a part from a random cell,
+     ML_NB_INIT times, the best cut is kept;
+   - uncoarsening: the partition is projected level by level and
+     refined with Fiduccia-Mattheyses passes.
+
+   All the state is in the object (the levels are kept between the
+   calls to reuse their memory), then two objects can be used
+   concurrently. The random generator is reseeded at each call, so the
+   result only depends on the hypergraph.
+ */
+class MultilevelBisection
+{
+  struct Level
+  {
+    int nbCell, nbNet;
+    vec<int> cellWeight;
+    vec<int> xpins, pins;  // the cells of each net
+    vec<int> xnets, nets;  // the nets of each cell
+    vec<int> coarseOf;     // the cell of the next level
+  };
+
+  struct GainLt
+  {
+    const vec<int> &gain;
+    GainLt(const vec<int> &g) : gain(g) {}
+    bool operator()(int a, int b) const {return gain[a] > gain[b];}
+  };
+
+  double imbalance;
+  uint64_t seed;
+
+  std::deque<Level> levels;  // never moved when it grows (a Level holds vecs, which realloc cannot move)
+  vec<int> part, bestPart, gain, pinCount, moves;
+  vec<bool> locked;
+  vec<int> order, mark;
+  vec<double> score;
+  Heap<GainLt> heap0, heap1;
+  int partWeight[2], totalWeight, bound;
+
+  inline unsigned nextRandom()
+  {
+    seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+    return (unsigned) (seed >> 32);
+  }// nextRandom
+
+  inline int penalty(){return (partWeight[0] > bound ? partWeight[0] - bound : 0) +
+      (partWeight[1] > bound ? partWeight[1] - bound : 0);}
+
+  void buildCellNets(Level &l);
+  bool coarsen(Level &fine, Level &coarse);
+  int initPartition(Level &l);
+  int computeCut(Level &l);
+  void computeGains(Level &l);
+  bool isBoundary(Level &l, int u);
+  void moveCell(Level &l, int u, bool updateGain);
+  int refine(Level &l, int cut);
+
+public:
+  MultilevelBisection(double _imbalance = 0.02);
+
+  int bisect(int nbCell, int nbNet, const int *cellWeight, const int *xpins, const int *pins,
+             int *partvec, int *partweights, int nbRun = 1);
+};
+
+#endif
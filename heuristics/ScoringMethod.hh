@@ -38,7 +38,7 @@ public:
    DIMACS Implementation Challenge.  American Mathematical Society,
    1993.
 */
-class Mom : public ScoringMethod
+class Mom final : public ScoringMethod
 {
 private:
   Solver &s;
@@ -53,9 +53,10 @@ public:
     int nbBin = om->getNbBinaryClause(v);
     Lit lp = mkLit(v, false);
       
-    for(int sign = 0 ; sign<2 ; sign++)
+    for(int sign = 0 ; sign<4 ; sign++)
       { 
-        vec<int> &occ = om->getVecIdxClause(sign ? lp : ~lp);
+        Lit l = (sign & 1) ? lp : ~lp;
+        VecView<int> occ = (sign & 2) ? om->getVecIdxBinaryClause(l) : om->getVecIdxClause(l);
           
         for(int i = 0 ; i<occ.size() ; i++) 
           {
@@ -79,7 +80,7 @@ public:
    and Sharad Malik. Chaff: Engineering an Efficient SAT Solver. In
    Proceedings of the 38th Design Automation Conference (DAC’01), 2001
 */
-class Vsids : public ScoringMethod
+class Vsids final : public ScoringMethod
 {
 private:
   vec<double> &activity;
@@ -94,7 +95,7 @@ public:
    This scoring function favorises the variables which appear in
    most clauses.
 */
-class Dlcs : public ScoringMethod
+class Dlcs final : public ScoringMethod
 {
 private:
   Solver &s;
@@ -114,7 +115,7 @@ public:
    problems. Annals of Mathematics and Artificial Intelligence,
    1:167–187, 1990.
 */
-class Jwts : public ScoringMethod
+class Jwts final : public ScoringMethod
 {
 private:
   Solver &s;
@@ -130,9 +131,10 @@ public:
     Lit lp = mkLit(v, false);
       
     double res = nbBin * 0.25;
-    for(int sign = 0 ; sign<2 ; sign++)
+    for(int sign = 0 ; sign<4 ; sign++)
       { 
-        vec<int> &occ = om->getVecIdxClause(sign ? lp : ~lp);
+        Lit l = (sign & 1) ? lp : ~lp;
+        VecView<int> occ = (sign & 2) ? om->getVecIdxBinaryClause(l) : om->getVecIdxClause(l);
           
         for(int i = 0 ; i<occ.size() ; i++) 
           {
@@ -156,7 +158,7 @@ public:
    Exact Model Counting. In Proceedings of the 8th International
    Conference on Theory and Applications of Satisfiability Testing.
 */
-class Vsads : public ScoringMethod
+class Vsads final : public ScoringMethod
 {
 private:
   OccurrenceManagerInterface *om;
@@ -0,0 +1,319 @@
+/*
+* d4
+* Copyright (C) 2020  Univ. Artois & CNRS
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <climits>
+#include <algorithm>
+
+#include "../mtl/Vec.hh"
+#include "../mtl/Heap.hh"
+#include "../mtl/Sort.hh"
+#include "../utils/System.hh"
+#include "../utils/SolverTypes.hh"
+
+#include "../heuristics/TreeDecompositionPartitioner.hh"
+
+using namespace std;
+
+
+struct FillLt
+{
+  const vec<int> &fill, &degree;
+  FillLt(const vec<int> &f, const vec<int> &d) : fill(f), degree(d) {}
+  bool operator()(Var a, Var b) const
+  {
+    return fill[a] < fill[b] || (fill[a] == fill[b] && degree[a] < degree[b]);
+  }
+};
+
+
+/**
+   Number of edges missing to make the neighbourhood of v a clique.
+
+   @param[in] adj, the graph where the eliminated variables are removed
+   @param[in] stamp, stampIdx, used to mark the neighbours of v
+   @param[out] work, incremented by the number of visited edges
+ */
+static int computeFill(vec<vec<Var> > &adj, Var v, vec<int> &stamp, int &stampIdx, long &work)
+{
+  vec<Var> &nv = adj[v];
+  stampIdx++;
+  for(int i = 0 ; i<nv.size() ; i++) stamp[nv[i]] = stampIdx;
+
+  long missing = 0;
+  for(int i = 0 ; i<nv.size() ; i++)
+    {
+      vec<Var> &na = adj[nv[i]];
+      int common = 0;
+      for(int j = 0 ; j<na.size() ; j++) common += stamp[na[j]] == stampIdx;
+      missing += nv.size() - 1 - common;
+      work += na.size();
+    }
+
+  missing >>= 1;
+  return missing > INT_MAX ? INT_MAX : (int) missing;
+}// computeFill
+
+
+/**
+   Compute the elimination order of the primal graph of the formula
+   and the elimination tree. When a variable is eliminated, only the
+   fill of its neighbours is updated, the other variables keep an upper
+   bound of their fill.
+
+   @param[in] om, the occurrence manager that gives the clauses
+ */
+void TreeDecomposition::compute(OccurrenceManagerInterface *om)
+{
+  double start = cpuTime();
+  int nbVar = om->getNbVariable();
+  computed = true;
+  valid = false;
+  width = 0;
+
+  // the primal graph
+  vec<vec<Var> > adj(nbVar);
+  long nbEdge = 0;
+  for(int i = 0 ; i<om->getNbClause() ; i++)
+    {
+      VecView<Lit> c = om->getClause(i);
+      for(int j = 0 ; j<c.size() ; j++)
+        for(int k = j + 1 ; k<c.size() ; k++)
+          {
+            adj[var(c[j])].push(var(c[k]));
+            adj[var(c[k])].push(var(c[j]));
+          }
+
+      nbEdge += (long) c.size() * (c.size() - 1) / 2;
+      if(nbEdge > TD_MAX_FILL_EDGE){time = cpuTime() - start; return;}
+    }
+
+  vec<int> stamp(nbVar, -1);
+  int stampIdx = 0;
+  for(int v = 0 ; v<nbVar ; v++)
+    {
+      vec<Var> &nv = adj[v];
+      stampIdx++;
+      int j = 0;
+      for(int i = 0 ; i<nv.size() ; i++)
+        if(nv[i] != v && stamp[nv[i]] != stampIdx){stamp[nv[i]] = stampIdx; nv[j++] = nv[i];}
+      nv.shrink(nv.size() - j);
+    }
+
+  // the elimination order
+  vec<int> fill(nbVar, 0), degree(nbVar);
+  long work = 0;
+  bool useFill = true;
+  for(int v = 0 ; v<nbVar ; v++)
+    {
+      degree[v] = adj[v].size();
+      if(useFill) fill[v] = computeFill(adj, v, stamp, stampIdx, work);
+      useFill = work < TD_MAX_FILL_WORK;
+    }
+  if(!useFill) for(int v = 0 ; v<nbVar ; v++) fill[v] = 0;
+
+  Heap<FillLt> heap((FillLt(fill, degree)));
+  for(int v = 0 ; v<nbVar ; v++) heap.insert(v);
+
+  vec<Var> order;
+  vec<int> xbags, bags; // the neighbours of each variable when it is eliminated
+  position.clear();
+  position.growTo(nbVar, -1);
+  xbags.push(0);
+  while(!heap.empty())
+    {
+      Var v = heap.removeMin();
+      vec<Var> &nv = adj[v];
+      position[v] = order.size();
+      order.push(v);
+      if(nv.size() > width) width = nv.size();
+      for(int i = 0 ; i<nv.size() ; i++) bags.push(nv[i]);
+      xbags.push(bags.size());
+
+      for(int i = 0 ; i<nv.size() ; i++) adj[nv[i]].removeElt(v);
+
+      // the neighbourhood of v becomes a clique
+      for(int i = 0 ; i<nv.size() ; i++)
+        {
+          vec<Var> &na = adj[nv[i]];
+          stampIdx++;
+          for(int j = 0 ; j<na.size() ; j++) stamp[na[j]] = stampIdx;
+          for(int j = 0 ; j<nv.size() ; j++)
+            if(j != i && stamp[nv[j]] != stampIdx){na.push(nv[j]); nbEdge += j > i;}
+          work += na.size();
+        }
+
+      if(nbEdge > TD_MAX_FILL_EDGE){time = cpuTime() - start; return;}
+
+      if(useFill && work >= TD_MAX_FILL_WORK)
+        {
+          // the fill is too expensive: min-degree on the remaining variables
+          useFill = false;
+          for(int i = 0 ; i<nbVar ; i++) fill[i] = 0;
+          vec<int> remaining;
+          for(int i = 0 ; i<nbVar ; i++) if(heap.inHeap(i)) remaining.push(i);
+          heap.build(remaining);
+        }
+
+      for(int i = 0 ; i<nv.size() ; i++)
+        {
+          Var a = nv[i];
+          degree[a] = adj[a].size();
+          if(useFill) fill[a] = computeFill(adj, a, stamp, stampIdx, work);
+          heap.update(a);
+        }
+      nv.clear(true);
+    }
+
+  // the parent of v is the neighbour of its bag eliminated first
+  parent.clear();
+  parent.growTo(nbVar, -1);
+  for(int v = 0 ; v<nbVar ; v++)
+    {
+      int p = -1, pos = position[v];
+      for(int i = xbags[pos] ; i<xbags[pos + 1] ; i++)
+        if(p == -1 || position[bags[i]] < position[p]) p = bags[i];
+      parent[v] = p;
+    }
+
+  computeTree();
+  valid = true;
+  time = cpuTime() - start;
+}// compute
+
+
+/**
+   Number the variables in depth first order: u is in the subtree of
+   v iff tin[v] <= tin[u] < tout[v].
+ */
+void TreeDecomposition::computeTree()
+{
+  int nbVar = parent.size();
+  vec<int> xchildren(nbVar + 1, 0), children(nbVar);
+  for(int v = 0 ; v<nbVar ; v++) if(parent[v] != -1) xchildren[parent[v] + 1]++;
+  for(int v = 0 ; v<nbVar ; v++) xchildren[v + 1] += xchildren[v];
+
+  vec<int> fillPos;
+  xchildren.copyTo(fillPos);
+  for(int v = 0 ; v<nbVar ; v++) if(parent[v] != -1) children[fillPos[parent[v]]++] = v;
+
+  tin.clear();
+  tout.clear();
+  tin.growTo(nbVar, -1);
+  tout.growTo(nbVar, -1);
+
+  int counter = 0;
+  vec<Var> stack;
+  vec<int> next;
+  for(int r = 0 ; r<nbVar ; r++)
+    {
+      if(parent[r] != -1) continue;
+
+      stack.push(r);
+      next.push(xchildren[r]);
+      tin[r] = counter++;
+      while(stack.size())
+        {
+          Var v = stack.last();
+          if(next.last() < xchildren[v + 1])
+            {
+              Var u = children[next.last()++];
+              tin[u] = counter++;
+              stack.push(u);
+              next.push(xchildren[u]);
+            }
+          else
+            {
+              tout[v] = counter;
+              stack.pop();
+              next.pop();
+            }
+        }
+    }
+}// computeTree
+
+
+/**
+   Index after the last variable of the subtree of sorted[i] (the
+   variables are sorted w.r.t. their depth first number).
+ */
+int TreeDecompositionPartitioner::endOfSubtree(int i)
+{
+  return std::lower_bound((int *) tins + i + 1, (int *) tins + tins.size(), shared->td.tout[sorted[i]]) - (int *) tins;
+}// endOfSubtree
+
+
+/**
+   Compute the cut of the current component. Since it is connected,
+   its variables are in the subtree of one of them, the root. The cut
+   is a path from the root: we go down while the current variable has
+   only one subtree with variables of the component (nothing is split
+   yet) or a subtree with more than half of them.
+
+   @param[in] component, the current set of variable defining the problem
+   @param[out] cutSet, not used
+   @param[out] cutVar, the variables of the cut
+ */
+void TreeDecompositionPartitioner::computePartition(vec<Var> &component, vec<int> &cutSet,
+                                                    vec<int> &cutVar, ScoringMethod *sm)
+{
+  std::call_once(shared->computed, [this](){shared->td.compute(om);});
+  TreeDecomposition &td = shared->td;
+
+  cutVar.clear();
+  if(!td.valid || !component.size()) return;
+
+  component.copyTo(sorted);
+  sort(sorted, TinLt(td.tin));
+  int n = sorted.size();
+  tins.clear();
+  for(int i = 0 ; i<n ; i++) tins.push(td.tin[sorted[i]]);
+  assert(endOfSubtree(0) == n);
+
+  int cur = 0;
+  cutVar.push(sorted[cur]);
+  for(;;)
+    {
+      int end = endOfSubtree(cur), nbSubtree = 0, heavy = -1, heavySize = 0;
+      for(int i = cur + 1 ; i<end ; nbSubtree++)
+        {
+          int next = endOfSubtree(i);
+          if(next - i > heavySize){heavy = i; heavySize = next - i;}
+          i = next;
+        }
+
+      if(!nbSubtree || (nbSubtree > 1 && 2 * heavySize <= n)) break;
+      cur = heavy;
+      cutVar.push(sorted[cur]);
+    }
+}// computePartition
+
+
+void TreeDecompositionPartitioner::shareWith(PartitionerInterface *ref)
+{
+  TreeDecompositionPartitioner *tdp = dynamic_cast<TreeDecompositionPartitioner *>(ref);
+  if(tdp) shared = tdp->shared;
+}// shareWith
+
+
+void TreeDecompositionPartitioner::printStatistics()
+{
+  PartitionerInterface::printStatistics();
+
+  TreeDecomposition &td = shared->td;
+  if(td.valid) printf("c Tree decomposition: width %d, computed in %.3lf s\n", td.width, td.time);
+  else if(td.computed) printf("c Tree decomposition: given up after %.3lf s (too many fill edges)\n", td.time);
+}// printStatistics
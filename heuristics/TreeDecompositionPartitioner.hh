@@ -0,0 +1,102 @@
+/*
+* d4
+* Copyright (C) 2020  Univ. Artois & CNRS
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef HEURISTICS_TREE_DECOMPOSITION_PARTITIONER
+#define HEURISTICS_TREE_DECOMPOSITION_PARTITIONER
+
+#include <memory>
+#include <mutex>
+
+#include "../utils/SolverTypes.hh"
+#include "../interfaces/OccurrenceManagerInterface.hh"
+#include "../interfaces/PartitionerInterface.hh"
+
+#define TD_MAX_FILL_WORK 100000000L // beyond, the fill is not computed anymore (min-degree)
+#define TD_MAX_FILL_EDGE 10000000L  // beyond, the decomposition is given up
+
+
+/**
+   Tree decomposition of the primal graph of the formula, given by an
+   elimination order computed with the min-fill heuristic (min-degree
+   when the computation of the fill becomes too expensive).
+
+   The tree is the elimination tree: the parent of a variable is its
+   neighbour, in the graph completed by the elimination, that is
+   eliminated first after it. Two variables in different subtrees are
+   not connected, then a connected set of variables has a highest
+   variable which is the ancestor of all the others.
+ */
+class TreeDecomposition
+{
+public:
+  bool computed;
+  bool valid;     // false if the decomposition has been given up
+  int width;
+  double time;
+  vec<int> position, parent, tin, tout;
+
+  TreeDecomposition() : computed(false), valid(false), width(0), time(0) {}
+  void compute(OccurrenceManagerInterface *om);
+
+  inline bool isAncestor(Var v, Var u){return tin[v] <= tin[u] && tin[u] < tout[v];}
+
+private:
+  void computeTree();
+};
+
+
+/**
+   Partitioner that uses a tree decomposition computed once, at the
+   first call: the cut of a component is the chain of the elimination
+   tree from its highest variable down to the first variable that has
+   several subtrees with variables of the component. Once the chain is
+   assigned, the component is split along these subtrees.
+
+   The decomposition is shared by the contexts of the parallel mode.
+ */
+class TreeDecompositionPartitioner : public PartitionerInterface
+{
+  struct Shared
+  {
+    std::once_flag computed;
+    TreeDecomposition td;
+  };
+
+  struct TinLt
+  {
+    const vec<int> &tin;
+    TinLt(const vec<int> &t) : tin(t) {}
+    bool operator()(Var a, Var b) const {return tin[a] < tin[b];}
+  };
+
+  OccurrenceManagerInterface *om;
+  std::shared_ptr<Shared> shared;
+  vec<Var> sorted;
+  vec<int> tins;
+
+  int endOfSubtree(int i);
+
+public:
+  TreeDecompositionPartitioner(OccurrenceManagerInterface *_om) : om(_om), shared(new Shared()) {}
+
+  void computePartition(vec<Var> &component, vec<int> &cutSet, vec<int> &cutVar, ScoringMethod *sm);
+  bool isUsedOn(int nbVar){return nbVar > 10;}
+  void shareWith(PartitionerInterface *ref);
+  void printStatistics();
+};
+
+#endif
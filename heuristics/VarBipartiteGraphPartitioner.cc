@@ -23,7 +23,6 @@
 #include "../interfaces/PartitionerInterface.hh"
 #include "../heuristics/VarBipartiteGraphPartitioner.hh"
 
-#include "../patoh/patoh.h"
 #include "../utils/equiv.hh"
 
 using namespace std;
@@ -39,8 +38,6 @@ void VarBipartiteGraphPartitioner::computePartition(vec<Var> &component, vec<int
 {
   assert(0);
   
-  PaToH_Parameters args;  
-  int cut;
   cutVar.clear();
 
   vec< vec<int> > occMap;
@@ -65,7 +62,7 @@ void VarBipartiteGraphPartitioner::computePartition(vec<Var> &component, vec<int
   for(int i = 0 ; i<idxClauses.size() ; i++)
     {
       xpins[i] = posPins;
-      vec<Lit> &c = om->getClause(idxClauses[i]);
+      VecView<Lit> c = om->getClause(idxClauses[i]);
       for(int j = 0 ; j<c.size() ; j++) pins[posPins++] = mapVar[var(c[j])];
     }
   xpins[idxClauses.size()] = posPins;
@@ -78,15 +75,9 @@ void VarBipartiteGraphPartitioner::computePartition(vec<Var> &component, vec<int
 #endif
       
   // hypergraph partitioner
-  if(idxClauses.size() < 200) PaToH_Initialize_Parameters(&args, PATOH_CONPART, PATOH_SUGPARAM_DEFAULT); 
-  else PaToH_Initialize_Parameters(&args, PATOH_CONPART, PATOH_SUGPARAM_QUALITY); 
-  
-  args._k = 2;
-  args.seed = 0;
-
   for(int i = 0 ; i<idxClauses.size() ; i++) cwghts[i] = 1;
-  PaToH_Alloc(&args, component.size(), idxClauses.size(), 1, cwghts, NULL, xpins, pins);
-  PaToH_Part(&args, component.size(), idxClauses.size(), 1, 0, cwghts, NULL, xpins, pins, NULL, partvec, partweights, &cut);
+  int cut = bisectHypergraph(component.size(), idxClauses.size(), cwghts, xpins, pins, partvec, partweights,
+                             idxClauses.size() >= 200);
 
 #if 1
   cout << "cut: " << cut << endl;  
@@ -94,7 +85,7 @@ void VarBipartiteGraphPartitioner::computePartition(vec<Var> &component, vec<int
   for(int i = 0 ; i<idxClauses.size() ; i++)
     {
       bool split = false;
-      vec<Lit> &c = om->getClause(idxClauses[i]);
+      VecView<Lit> c = om->getClause(idxClauses[i]);
       for(int j = 1 ; !split && j<c.size() ; j++)
         split = partvec[mapVar[var(c[j])]] != partvec[mapVar[var(c[0])]];
 
@@ -109,7 +100,6 @@ void VarBipartiteGraphPartitioner::computePartition(vec<Var> &component, vec<int
 #endif
 
   for(int i = 0 ; i<component.size() ; i++) inCurrentComponent[component[i]] = false; 
-  PaToH_Free();  
 }// computePartition
 
 
@@ -124,7 +114,7 @@ void VarBipartiteGraphPartitioner::computeUselessClauses(vec<int> &idxClauses, v
   for(int i = 0 ; i<idxClauses.size() ; i++)
     {
       if(idxClauses[i] == -1) continue;
-      vec<Lit> &c = om->getClause(idxClauses[i]);
+      VecView<Lit> c = om->getClause(idxClauses[i]);
       for(int j = 0 ; j<c.size() ; j++) markedVar[var(c[j])] = true;          // we mark the clause
 
       // search a variable in c that minimized the number of occurrences
@@ -146,7 +136,7 @@ void VarBipartiteGraphPartitioner::computeUselessClauses(vec<int> &idxClauses, v
             {
               int idxCl = occMap[mapVar[v]][j];                
               if(idxCl == i || idxClauses[idxCl] == -1) continue;
-              vec<Lit> &d = om->getClause(idxClauses[idxCl]);
+              VecView<Lit> d = om->getClause(idxClauses[idxCl]);
 
               int cpt = 0;
               for(int k = 0 ; cpt < nbAvailableVar && k<d.size() ; k++)
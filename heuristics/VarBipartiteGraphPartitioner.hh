@@ -73,7 +73,7 @@ public:
         bool cover = true;
         for(int i = 0 ; cover && i<occVar[v].size() ; i++)
           {
-            vec<Lit> &c = om->getClause(occVar[v][i]);
+            VecView<Lit> c = om->getClause(occVar[v][i]);
             for(int j = 0 ; cover && j<c.size() ; j++) cover = partvec[mapVar[var(c[j])]] != grp || present[var(c[j])];             
           }
 
@@ -92,7 +92,7 @@ public:
     vec< vec<int> > occVar;
     for(int i = 0 ; i<cutSet.size() ; i++)
       {
-        vec<Lit> &c = om->getClause(cutSet[i]);
+        VecView<Lit> c = om->getClause(cutSet[i]);
         for(int j = 0 ; j<c.size() ; j++)
           {
             while(occVar.size() <= var(c[j])) occVar.push();
@@ -127,7 +127,7 @@ public:
     for(int i = 0 ; i<occMap.size() ; i++) occMap[i].clear(); 
     for(int i = 0 ; i<idxClauses.size() ; i++)
       {
-        vec<Lit> &c = om->getClause(idxClauses[i]);
+        VecView<Lit> c = om->getClause(idxClauses[i]);
         for(int j = 0 ; j<c.size() ; j++)
           if(!om->litIsAssigned(c[j]) && !useLessVariable[var(c[j])]) occMap[mapVar[var(c[j])]].push(i);          
       }
@@ -170,14 +170,14 @@ public:
           
         // init with the first clause
         int nbLit = 0;
-        vec<Lit> &c = om->getClause(idxClauses[occMap[i][0]]);
+        VecView<Lit> c = om->getClause(idxClauses[occMap[i][0]]);
         for(int j = 0 ; j<c.size() ; j++) if(!om->litIsAssigned(c[j])){markedVar[var(c[j])] = true; nbLit++;}
 
         bool notUseFul = true;
         int cpt = 0;
         for(int j = 1 ; notUseFul && j<occMap[i].size() ; j++)
           {            
-            vec<Lit> &d = om->getClause(idxClauses[occMap[i][j]]);
+            VecView<Lit> d = om->getClause(idxClauses[occMap[i][j]]);
             for(int k = 0 ; notUseFul && k<d.size() ; k++)
               if(!om->litIsAssigned(d[k])){notUseFul = markedVar[var(d[k])]; cpt++;}
           }
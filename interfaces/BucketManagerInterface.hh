@@ -24,48 +24,45 @@
 
 #include "../utils/SolverTypes.hh"
 #include "../manager/CacheBucket.hh"
+#include "../manager/SlabAllocator.hh"
 
 #define ALL 0
 #define NB 1
 #define NT 2
 
+#define REPR_CL 0
+#define REPR_CP 1
+
 #define ONE_OCTET 2
 #define TWO_OCTET 3
 #define FOUR_OCTET 4
 #define EIGHT_OCTET 5
 
-#define PAGE (1<<29)
-
 template<class T> class BucketManagerInterface
 {
 protected:
   int modeStore;
-  vec<char *> allocateData;
-  char *data;
-  unsigned long int sizeData, posInData;
+  int modeRepr;
   CacheBucket<T> bucket;
 
  public:
-  vec<vec<char *>> freeSpace;  // freespace[i][j] points to a free memory space of size i
-  unsigned long int allMemory;
-  unsigned long int freeMemory;
-  unsigned long int pageData;
-
   virtual void storeFormula(vec<Var> &component, CacheBucket<T> &b) = 0;
-  inline void setFixeFormula(const char *cacheStore)
+  virtual uint64_t computeSignature(vec<Var> &component) = 0;
+  inline void setFixeFormula(const char *cacheStore, bool verb = true)
   {
     if(!strcmp(cacheStore, "ALL")) modeStore = ALL;
     if(!strcmp(cacheStore, "NB")) modeStore = NB;
     if(!strcmp(cacheStore,"NT")) modeStore = NT;
-    std::cout << "c Strategy: " << modeStore << std::endl;
+    if(verb) std::cout << "c Strategy: " << modeStore << std::endl;
   }
 
-  virtual ~BucketManagerInterface()
+  inline void setRepresentation(const char *cacheRepresentation)
   {
-    for(int i = 0 ; i<allocateData.size() ; i++) delete[](allocateData[i]);
-    allocateData.clear();
+    modeRepr = !strcmp(cacheRepresentation, "CP") ? REPR_CP : REPR_CL;
   }
 
+  virtual ~BucketManagerInterface(){}
+
   inline int nbOctetToEncodeInt(unsigned int v) // we know that we cannot have more than 1<<32 variables
   {
     if(v < (1<<8)) return 1;
@@ -74,103 +71,34 @@ protected:
   }// nbOctetToEncodeInt
 
 
-  inline double remainingMemory()
-  {
-    return ((double) freeMemory + (sizeData - posInData)) / (double) sizeData;
-  } // remainingMemory
-
-
   /**
-     Initialize the data structure regarding the configuration (ie. number of
-     variables, maximum number of clauses and the lenght of the largest clause).
+     Initialize the data structure. No memory is reserved here: the
+     arrays are taken on demand from the allocator shared by all the
+     bucket managers.
    */
-  void init(int nbVar, int nbClause, int maxSizeClause, int strategyCache)
+  void init()
   {
     modeStore = NT;
-    allMemory = freeMemory = posInData = 0;
-    switch(strategyCache)
-    {
-      case 1 : sizeData = ((unsigned long int)1<<32) * sizeof(char); break;
-      case 2 : ;
-      case 0 : sizeData = PAGE * sizeof(char); break;
-    }
-
-    // we cannot reinit ... at least for the moment
-    assert(!allocateData.size());
-    data = new char[sizeData];
-    allocateData.push(data);
-    allMemory += sizeData;
+    modeRepr = REPR_CL;
   } // init
 
 
   /**
      Get a pointer on an available array where we can store the data we want to
-     save into the bucket.
+     save into the bucket. The memory is shared by all the bucket managers
+     (see SlabAllocator), then an array can be released by another bucket
+     manager than the one that gave it.
    */
-  char *getArray(int size)
-  {
-    char *ret = NULL;
-
-    if(size < freeSpace.size() && freeSpace[size].size())
-    {
-      ret = freeSpace[size].last();
-      freeSpace[size].pop();
-      freeMemory -= size;
-      return ret;
-    }
-
-    // go futher to see if we cannot split some entry
-    if((size << 1) < freeSpace.size())
-    {
-      int pos = size << 1;
-      while(pos < freeSpace.size() && !freeSpace[pos].size()) pos++;
-
-      // split an entry
-      if(pos < freeSpace.size())
-      {
-        ret = freeSpace[pos].last();
-        freeSpace[pos].pop();
-        freeMemory -= size;
-        freeSpace[pos - size].push(&ret[size]); // split and push
-        return ret;
-      }
-    }
-
-    // take a fresh entry
-    if(posInData + size > sizeData)
-    {
-      int rSz = sizeData - posInData;
-      while(freeSpace.size() <= rSz) freeSpace.push();
-      freeSpace[rSz].push(&data[posInData]);
-      freeMemory += rSz;
-
-      printf("c Allocate a new page for the cache %lu\n", freeMemory);
-      posInData = 0;
-      data = new char[sizeData];
-      allocateData.push(data);
-
-      allMemory += sizeData;
-    }
-
-    ret = &data[posInData];
-    posInData += size;
-    return ret;
-  } // getArray
+  inline char *getArray(int size){return SlabAllocator::global().allocate(size);}
 
 
   /**
-     Release some memory of a given size and store this information in
-     freespace.
+     Release some memory of a given size.
 
      @param[in] m, the memory we want to release
      @param[in] size, the size of the memory block
    */
-  inline void releaseMemory(char *m, int size)
-  {
-    while(freeSpace.size() <= size) freeSpace.push();
-    freeSpace[size].push(m);
-    freeMemory += size;
-  }// reverseLastBucket
+  inline void releaseMemory(char *m, int size){SlabAllocator::global().release(m, size);}
 
 
   /**
@@ -0,0 +1,41 @@
+/*
+* d4
+* Copyright (C) 2020  Univ. Artois & CNRS
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <cstring>
+
+#include "../interfaces/CacheAdmissionInterface.hh"
+#include "../manager/CacheAdmission.hh"
+
+
+bool CacheAdmissionInterface::isPolicy(const char *policy)
+{
+  return !strcmp(policy, "ALL") || !strcmp(policy, "SECOND") || !strcmp(policy, "FREQ");
+}// isPolicy
+
+
+/**
+   Create the admission policy of a shard.
+
+   @param[in] policy, ALL, SECOND or FREQ (see CacheAdmission.hh)
+   @param[in] minVar, maxVar, the bounds on the number of variables of the stored formulas
+ */
+CacheAdmissionInterface *CacheAdmissionInterface::getAdmission(const char *policy, int minVar, int maxVar)
+{
+  if(!strcmp(policy, "SECOND")) return new SecondMissAdmission(minVar, maxVar);
+  if(!strcmp(policy, "FREQ")) return new FrequencyAdmission(minVar, maxVar);
+  return new CacheAdmissionInterface(minVar, maxVar);
+}// getAdmission
@@ -0,0 +1,61 @@
+/*
+* d4
+* Copyright (C) 2020  Univ. Artois & CNRS
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef CACHE_ADMISSION_INTERFACE
+#define CACHE_ADMISSION_INTERFACE
+
+#include <cstdint>
+
+/**
+   Decide which of the formulas missed by the cache are stored once
+   their value is computed. Each shard of the cache has its own policy,
+   only called under the lock of the shard, with the fingerprints of the
+   formulas of this shard.
+ */
+class CacheAdmissionInterface
+{
+protected:
+  int minVar, maxVar; // maxVar is 0 when there is no limit
+
+public:
+  CacheAdmissionInterface(int _minVar, int _maxVar) : minVar(_minVar), maxVar(_maxVar) {}
+  virtual ~CacheAdmissionInterface(){}
+
+  /**
+     Called each time the cache is searched.
+
+     @param[in] fp, the fingerprint of the formula
+   */
+  virtual void recordAccess(uint64_t fp){}
+
+  /**
+     Decide if a formula of the right size is stored.
+
+     @param[in] fp, the fingerprint of the formula
+   */
+  virtual bool admitFormula(uint64_t fp){return true;}
+
+  inline bool admit(uint64_t fp, int nbVar)
+  {
+    if(nbVar < minVar || (maxVar && nbVar > maxVar)) return false;
+    return admitFormula(fp);
+  }// admit
+
+  static bool isPolicy(const char *policy);
+  static CacheAdmissionInterface *getAdmission(const char *policy, int minVar, int maxVar);
+};
+#endif
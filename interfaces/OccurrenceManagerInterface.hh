@@ -20,11 +20,11 @@
 
 #include "../utils/SolverTypes.hh"
 #include "../utils/Solver.hh"
+#include "../mtl/VecView.hh"
 
 class OccurrenceManagerInterface
 {
 public:
-  vec< vec<int> > occList;
   virtual ~OccurrenceManagerInterface(){}
 
   virtual int getNbBinaryClause(Var v) = 0;
@@ -35,10 +35,12 @@ public:
   virtual int getNbClause(Lit l) = 0;
   virtual int getNbClause() = 0;
 
-  virtual vec<Lit> &getClause(int idx) = 0;
+  virtual VecView<Lit> getClause(int idx) = 0;
   virtual int getSizeClause(int idx){return getClause(idx).size();}
-  virtual vec<int> &getVecIdxClause(Lit l) = 0;
+  virtual VecView<int> getVecIdxClause(Lit l) = 0;        // the clauses of l that are not binary
+  virtual VecView<int> getVecIdxBinaryClause(Lit l) = 0;  // the binary clauses of l
   virtual int getNbUnsat(int idx) = 0;
+  virtual uint64_t getResidualHash(int idx) = 0;
   virtual int getNbVariable() = 0;
   virtual int getSumSizeClauses() = 0;
 
@@ -48,13 +50,13 @@ public:
   virtual bool varIsAssigned(Var v) = 0;
   virtual int getMaxSizeClause() = 0;
   virtual bool isSatisfiedClause(int idx) = 0;
-  virtual bool isSatisfiedClause(vec<Lit> &c) = 0;
+  virtual bool isSatisfiedClause(VecView<Lit> c) = 0;
   virtual bool isNotSatisfiedClauseAndInComponent(int idx, vec<bool> &inCurrentComponent) = 0;
 
-  inline const vec< vec<int> > &getOccurrenceList(){return occList;}
-
   virtual int computeConnectedComponent(vec<vec<Var> > &varConnected, vec<Var> &setOfVar,
                                         vec<Var> &freeVar, vec<Var> &notFreeVar) = 0;
+  virtual unsigned long int getNbComponentVisit(){return 0;}
+  virtual unsigned long int getNbAvoidedComponentVisit(){return 0;}
   virtual void preUpdate(vec<Lit> &lits) = 0;
   virtual void postUpdate(vec<Lit> &lits) = 0;
   virtual void initialize(vec<Var> &setOfVar, vec<Lit> &units) = 0;
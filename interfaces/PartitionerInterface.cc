@@ -18,10 +18,168 @@
 #include "../interfaces/OccurrenceManagerInterface.hh"
 #include "../mtl/Vec.hh"
 #include "../utils/SolverTypes.hh"
+#include "../utils/System.hh"
+#include "../hashing/HashCnf.hh"
 
 #include "../interfaces/PartitionerInterface.hh"
 #include "../heuristics/ClauseBipartiteGraphPartitioner.hh"
 #include "../heuristics/VarBipartiteGraphPartitioner.hh"
+#include "../heuristics/TreeDecompositionPartitioner.hh"
+
+#ifndef NPATOH
+#include "../patoh/patoh.h"
+#endif
+
+std::mutex PartitionerInterface::patohMutex;
+
+
+/**
+   Check the name of a hypergraph partitioner (-hp): ML (the built-in
+   multilevel bisection) or PATOH (when d4 is linked with it).
+ */
+bool PartitionerInterface::isHypergraphPartitioner(const char *hp)
+{
+#ifndef NPATOH
+  if(!strcmp(hp, "PATOH")) return true;
+#endif
+  return !strcmp(hp, "ML");
+}// isHypergraphPartitioner
+
+
+/**
+   Split the cells of a hypergraph in two parts, minimizing the number
+   of nets that have cells in both parts.
+
+   @param[in] nbCell, nbNet, the size of the hypergraph
+   @param[in] cwghts, the weight of the cells
+   @param[in] xpins, pins, the cells of each net
+   @param[out] partvec, the part of each cell
+   @param[out] partweights, the weight of the two parts
+   @param[in] quality, spend more time on the partition
+   \return the number of cut nets
+ */
+int PartitionerInterface::bisectHypergraph(int nbCell, int nbNet, int *cwghts, int *xpins, int *pins,
+                                           int *partvec, int *partweights, bool quality)
+{
+#ifndef NPATOH
+  if(usePatoh)
+    {
+      // PaToH works on a global state
+      std::lock_guard<std::mutex> lockPatoh(patohMutex);
+      PaToH_Parameters args;
+      int cut;
+      PaToH_Initialize_Parameters(&args, PATOH_CONPART, quality ? PATOH_SUGPARAM_QUALITY : PATOH_SUGPARAM_DEFAULT);
+      args._k = 2;
+      args.seed = 1;
+
+      PaToH_Alloc(&args, nbCell, nbNet, 1, cwghts, NULL, xpins, pins);
+      PaToH_Part(&args, nbCell, nbNet, 1, 0, cwghts, NULL, xpins, pins, NULL, partvec, partweights, &cut);
+      PaToH_Free();
+      return cut;
+    }
+#endif
+
+  return bisection.bisect(nbCell, nbNet, cwghts, xpins, pins, partvec, partweights, quality ? ML_NB_RUN_QUALITY : 1);
+}// bisectHypergraph
+
+
+/**
+   Replace the cut of an entry of the cache. The cut is written at the
+   end of the pool, which is compacted when the cuts no more in the
+   cache take more than half of it.
+
+   @param[out] e, the entry
+   @param[in] cutVar, its new cut
+ */
+void PartitionerInterface::storeCut(CutEntry &e, vec<int> &cutVar)
+{
+  nbPoolUsed -= e.size;
+  e.size = 0;
+
+  if(cutPool.size() > 2 * nbPoolUsed + PARTITION_CACHE_SIZE)
+    {
+      vec<Var> pool;
+      for(int i = 0 ; i<cutCache.size() ; i++)
+        {
+          CutEntry &o = cutCache[i];
+          int start = pool.size();
+          for(int j = 0 ; j<o.size ; j++) pool.push(cutPool[o.start + j]);
+          o.start = start;
+        }
+      pool.moveTo(cutPool);
+    }
+
+  e.start = cutPool.size();
+  e.size = cutVar.size();
+  for(int i = 0 ; i<cutVar.size() ; i++) cutPool.push(cutVar[i]);
+  nbPoolUsed += e.size;
+}// storeCut
+
+
+/**
+   Compute the cut of a component, or take the one computed the last
+   time the same set of variables was met.
+
+   @param[in] component, the current set of variable defining the problem
+   @param[out] cutVar, the variables of the cut
+   @param[in] sm, the scoring method of the variable heuristic
+   \return true if the cut has been found in the cache (the partitioner is not called)
+ */
+bool PartitionerInterface::computeCut(vec<Var> &component, vec<int> &cutVar, ScoringMethod *sm)
+{
+  if(!cutCache.size()) cutCache.growTo(PARTITION_CACHE_SIZE);
+  nbCutSearch++;
+
+  uint64_t sig = 0;
+  for(int i = 0 ; i<component.size() ; i++) sig += HashCnf::zobristVar(component[i]);
+  if(!sig) sig = 1;
+  CutEntry &e = cutCache[sig & (PARTITION_CACHE_SIZE - 1)];
+
+  if(e.sig == sig && e.nbVar == component.size())
+    {
+      // the cut must be a subset of the component, even in case of collision
+      stampIdx++;
+      for(int i = 0 ; i<component.size() ; i++)
+        {
+          if(component[i] >= stampVar.size()) stampVar.growTo(component[i] + 1, 0);
+          stampVar[component[i]] = stampIdx;
+        }
+
+      bool isIn = true;
+      for(int i = 0 ; isIn && i<e.size ; i++)
+        {
+          Var v = cutPool[e.start + i];
+          isIn = v < stampVar.size() && stampVar[v] == stampIdx;
+        }
+
+      if(isIn)
+        {
+          nbCutHit++;
+          cutVar.clear();
+          for(int i = 0 ; i<e.size ; i++) cutVar.push(cutPool[e.start + i]);
+          return true;
+        }
+    }
+
+  double start = cpuTime();
+  vec<int> cutSet;
+  computePartition(component, cutSet, cutVar, sm);
+  timeCut += cpuTime() - start;
+
+  e.sig = sig;
+  e.nbVar = component.size();
+  storeCut(e, cutVar);
+  return false;
+}// computeCut
+
+
+void PartitionerInterface::printStatistics()
+{
+  unsigned nbMiss = nbCutSearch - nbCutHit;
+  printf("c Number of cuts found in the partition cache: %u/%u (%.3lf s of partitioner saved)\n",
+         nbCutHit, nbCutSearch, nbMiss ? timeCut * nbCutHit / nbMiss : 0);
+}// printStatistics
+
 
 PartitionerInterface *PartitionerInterface::getPartitioner(Solver &s, OccurrenceManagerInterface *om, OptionManager &optList)
 {
@@ -32,13 +190,16 @@ PartitionerInterface *PartitionerInterface::getPartitioner(Solver &s, Occurrence
       pv = new ClauseBipartiteGraphPartitioner(s, om);
       pv->setReduceFormula(optList.reducePrimalGraph);
       pv->setEquivSimp(optList.equivSimplification);
+      pv->setUsePatoh(!strcmp(optList.hypergraphPartitioner, "PATOH"));
     }
   else if(!strcmp(optList.partitionHeuristic, "VB"))
     {
       pv = new VarBipartiteGraphPartitioner(s, om);
       pv->setReduceFormula(optList.reducePrimalGraph);
       pv->setEquivSimp(optList.equivSimplification);
+      pv->setUsePatoh(!strcmp(optList.hypergraphPartitioner, "PATOH"));
     }
+  else if(!strcmp(optList.partitionHeuristic, "TD")) pv = new TreeDecompositionPartitioner(om);
   else
     {
       cerr << "Not available partioner" << endl;
@@ -19,25 +19,73 @@
 #define PARTITIONER_INTERFACE
 
 #include "../manager/OptionManager.hh"
+#include "../heuristics/MultilevelBisection.hh"
+#include <cstdint>
 #include <cstring>
+#include <mutex>
+
+#define PARTITION_CACHE_SIZE 4096 // number of cuts kept (power of two)
 
 using namespace std;
 
 class PartitionerInterface
 {
+  /**
+     A cut computed for a set of variables: the same component comes
+     back in sibling subtrees (after a miss of the cache of the counter
+     because the residual clauses differ) and the cut is only used to
+     order the decisions, then it is reused. The variables of the cut
+     are cutPool[start ... start + size - 1].
+   */
+  struct CutEntry
+  {
+    uint64_t sig;  // sum of the Zobrist keys of the variables, 0 if empty
+    int nbVar;
+    int start, size;
+
+    CutEntry() : sig(0), nbVar(0), start(0), size(0) {}
+  };
+
+  vec<CutEntry> cutCache;
+  vec<Var> cutPool;     // the cuts of cutCache, compacted when half of it is not used anymore
+  int nbPoolUsed;
+  vec<unsigned> stampVar;
+  unsigned stampIdx;
+  unsigned nbCutSearch, nbCutHit;
+  double timeCut;
+
+  void storeCut(CutEntry &e, vec<int> &cutVar);
+
 public:
   virtual ~PartitionerInterface(){}
   bool reduceFormula;
   bool equivSimp;
+  bool usePatoh;
+  MultilevelBisection bisection;
+
+  PartitionerInterface() : nbPoolUsed(0), stampIdx(0), nbCutSearch(0), nbCutHit(0), timeCut(0),
+                           reduceFormula(false), equivSimp(false), usePatoh(false) {}
 
   inline void setReduceFormula(bool b){reduceFormula = b;}
   inline void setEquivSimp(bool b){equivSimp = b;}
+  inline void setUsePatoh(bool b){usePatoh = b;}
     
   virtual void computePartition(vec<Var> &component, vec<Var> &partition, vec<int> &cutVar, ScoringMethod *sm)
   {
     component.copyTo(partition);
   }
 
+  virtual bool isUsedOn(int nbVar){return nbVar > 10 && nbVar < 5000;}  // the size of the components we split
+  virtual void shareWith(PartitionerInterface *ref){}                     // share what is computed once with ref
+  virtual void printStatistics();
+
+  bool computeCut(vec<Var> &component, vec<int> &cutVar, ScoringMethod *sm);
+
+  int bisectHypergraph(int nbCell, int nbNet, int *cwghts, int *xpins, int *pins, int *partvec,
+                       int *partweights, bool quality);
+
+  static bool isHypergraphPartitioner(const char *hp);
+  static std::mutex patohMutex; // PaToH is not reentrant: serialize the calls made by concurrent workers
   static PartitionerInterface *getPartitioner(Solver &s, OccurrenceManagerInterface *om, OptionManager &optList);
 };  
 #endif
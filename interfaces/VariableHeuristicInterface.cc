@@ -43,11 +43,11 @@ using namespace std;
 VariableHeuristicInterface::VariableHeuristicInterface(Solver &_s, OccurrenceManagerInterface *_occM, const char *v, const char *p, vec<bool> &isProj) :
   s(_s), occM(_occM)
 {    
-  if(!strcmp(v, "VSADS")) sm = new Vsads(occM, s.scoreActivity);
-  else if(!strcmp(v, "VSIDS")) sm = new Vsids(s.scoreActivity);
-  else if(!strcmp(v, "DLCS")) sm = new Dlcs(s, occM);
-  else if(!strcmp(v, "JW-TS")) sm = new Jwts(s, occM);
-  else if(!strcmp(v, "MOM")) sm = new Mom(s, occM);
+  if(!strcmp(v, "VSADS")) {sm = new Vsads(occM, s.scoreActivity); kindScore = SCORE_VSADS;}
+  else if(!strcmp(v, "VSIDS")) {sm = new Vsids(s.scoreActivity); kindScore = SCORE_VSIDS;}
+  else if(!strcmp(v, "DLCS")) {sm = new Dlcs(s, occM); kindScore = SCORE_DLCS;}
+  else if(!strcmp(v, "JW-TS")) {sm = new Jwts(s, occM); kindScore = SCORE_JWTS;}
+  else if(!strcmp(v, "MOM")) {sm = new Mom(s, occM); kindScore = SCORE_MOM;}
   else {fprintf(stderr, "%s: this variable heuristic is unknow\n", v); exit(32);}
 
   if(!strcmp(p, "OCCURRENCE")) ps= new PhaseOccurrence(occM);
@@ -60,6 +60,34 @@ VariableHeuristicInterface::VariableHeuristicInterface(Solver &_s, OccurrenceMan
 }// constructor
 
 
+/**
+   Search the variable of the component with the best score. The
+   scoring class is given with its type, so that computeScore is
+   inlined in the loop instead of being called through the virtual
+   table for each variable.
+
+   @param[in] score, the scoring function
+   @param[in] component, the current problem's variables.
+   \return the best variable, var_Undef if any variable can be assigned
+ */
+template<class S> Var VariableHeuristicInterface::selectBest(S *score, vec<Var> &component)
+{
+  Var next = var_Undef;
+  double maxScore = -1;
+
+  for(int i = 0 ; i<component.size() ; i++)
+    {
+      Var v = component[i];
+      if(s.value(v) != l_Undef || !varProjected[v]) continue;
+
+      double sc = score->computeScore(v);
+      if(next == var_Undef || sc > maxScore){next = v; maxScore = sc;}
+    }
+
+  return next;
+}// selectBest
+
+
 /**
    Select a new decision variable w.r.t. the scoring function
    initially chosen (see the constructor for more information).
@@ -70,16 +98,15 @@ VariableHeuristicInterface::VariableHeuristicInterface(Solver &_s, OccurrenceMan
 Var VariableHeuristicInterface::selectVariable(vec<Var> &component)
 {    
   Var next = var_Undef; 
-  double maxScore = -1;
   sm->initStructure(component);
-  
-  for(int i = 0 ; i<component.size() ; i++) 
-    {      
-      Var v = component[i];      
-      if(s.value(v) != l_Undef || !varProjected[v]) continue;
-      
-      double score = sm->computeScore(v);	  
-      if(next == var_Undef || score > maxScore){next = v; maxScore = score;}
+
+  switch(kindScore)
+    {
+    case SCORE_VSADS: next = selectBest(static_cast<Vsads *>(sm), component); break;
+    case SCORE_VSIDS: next = selectBest(static_cast<Vsids *>(sm), component); break;
+    case SCORE_DLCS: next = selectBest(static_cast<Dlcs *>(sm), component); break;
+    case SCORE_JWTS: next = selectBest(static_cast<Jwts *>(sm), component); break;
+    case SCORE_MOM: next = selectBest(static_cast<Mom *>(sm), component); break;
     }
 
   assert(next == var_Undef || varProjected[next]);
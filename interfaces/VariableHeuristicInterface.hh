@@ -31,6 +31,9 @@ private:
   OccurrenceManagerInterface *occM;
   ScoringMethod *sm;
   PhaseSelection *ps;
+
+  enum {SCORE_VSADS, SCORE_VSIDS, SCORE_DLCS, SCORE_JWTS, SCORE_MOM} kindScore;
+  template<class S> Var selectBest(S *score, vec<Var> &component);
     
 public:
   vec<bool> varProjected;
@@ -43,6 +43,7 @@ using namespace std;
 #include "../DAG/DAG.hh"
 
 #include "../manager/CacheBucket.hh"
+#include "../manager/CompressedKey.hh"
 
 #define MASK 16383
 #define MASK_HEADER 1048575
@@ -66,7 +67,6 @@ template<class T> class BucketManager : public BucketManagerInterface<T>
   int nbClauseCnf, nbVarCnf;
   vec<int> distribClauseNbVar;
   int lastSize;
-  int strategyCache;
 
   /**
      Update the bucket manager to considere a new occurrence manager.
@@ -93,7 +93,7 @@ template<class T> class BucketManager : public BucketManagerInterface<T>
     for(int i = markIdx.size() ; i<nbClauseCnf ; i++) markIdx.push(-1);
     for(int i = 0 ; i <= maxSizeClause; i++) distribClauseNbVar.push(0);
 
-    this->init(nbVar, nbClause, maxSizeClause, strategyCache);
+    this->init();
   }// updateOccManager
 
 
@@ -105,56 +105,59 @@ template<class T> class BucketManager : public BucketManagerInterface<T>
   void createDistribWrTLit(Lit l)
   {
     assert(occManager);
-    vec<int> &idxClauses = occManager->getVecIdxClause(l);
     int ownBucket = -1;
 
-    for(int j = 0 ; j<idxClauses.size() ; j++)
+    // the binary clauses are not stored in the NB mode
+    for(int b = 0 ; b<(BucketManagerInterface<T>::modeStore == NB ? 1 : 2) ; b++)
     {
-      int idx = idxClauses[j];
-
-      if(BucketManagerInterface<T>::modeStore == NT && !occManager->getNbUnsat(idx)) continue;
-      vec<Lit> &c = occManager->getClause(idx);
-      if(BucketManagerInterface<T>::modeStore == NB && c.size() <= 2) continue;
-
-      assert(idx < markIdx.size());
-      if(!markView[idx])
+      VecView<int> idxClauses = b ? occManager->getVecIdxBinaryClause(l) : occManager->getVecIdxClause(l);
+      for(int j = 0 ; j<idxClauses.size() ; j++)
       {
-        markView[idx] = true;
-        mustUnMark.push(idx);
+        int idx = idxClauses[j];
 
-        if(ownBucket == -1) // create its own bucket
-        {
-          ownBucket = vecBucketSortIntervalle.size();
-          vecBucketSortIntervalle.push((bucketSortInfo) {distrib.size(), distrib.size()});
-          refCutBucket.push(ownBucket);
-        }
+        if(BucketManagerInterface<T>::modeStore == NT && !occManager->getNbUnsat(idx)) continue;
+        if(BucketManagerInterface<T>::modeStore == NB && occManager->getSizeClause(idx) <= 2) continue;
 
-        markIdx[idx] = ownBucket;
-        distrib.inc();
-        (distrib.last()).setSize(0);
-        (distrib.last()).push_(l);
-        vecBucketSortIntervalle[ownBucket].end++;
-      }else
-      {
-        int bkNew = markIdx[idx], bkOld = bkNew;
-        assert(bkNew < refCutBucket.size());
-
-        if(refCutBucket[bkNew] == bkNew)
+        assert(idx < markIdx.size());
+        if(!markView[idx])
+        {
+          markView[idx] = true;
+          mustUnMark.push(idx);
+
+          if(ownBucket == -1) // create its own bucket
+          {
+            ownBucket = vecBucketSortIntervalle.size();
+            vecBucketSortIntervalle.push((bucketSortInfo) {distrib.size(), distrib.size()});
+            refCutBucket.push(ownBucket);
+          }
+
+          markIdx[idx] = ownBucket;
+          distrib.inc();
+          (distrib.last()).setSize(0);
+          (distrib.last()).push_(l);
+          vecBucketSortIntervalle[ownBucket].end++;
+        }else
         {
-          bucketSortInfo tmp = vecBucketSortIntervalle[bkNew];
-          tmp.end = tmp.start;
-          vecBucketSortIntervalle.push(tmp);
-          bkNew = vecBucketSortIntervalle.size() - 1;
-          refCutBucket.push(bkNew);
-          refCutBucket[bkOld] = bkNew;
-        }else bkNew = refCutBucket[bkNew];
-
-        markIdx[idx] = bkNew;
-        vecBucketSortIntervalle[bkOld].start++;
-        bucketSortInfo &currB = vecBucketSortIntervalle[bkNew];
-
-        assert(distrib[currB.end].size() < distrib[currB.end].capacity());
-        distrib[currB.end++].push_(l);
+          int bkNew = markIdx[idx], bkOld = bkNew;
+          assert(bkNew < refCutBucket.size());
+
+          if(refCutBucket[bkNew] == bkNew)
+          {
+            bucketSortInfo tmp = vecBucketSortIntervalle[bkNew];
+            tmp.end = tmp.start;
+            vecBucketSortIntervalle.push(tmp);
+            bkNew = vecBucketSortIntervalle.size() - 1;
+            refCutBucket.push(bkNew);
+            refCutBucket[bkOld] = bkNew;
+          }else bkNew = refCutBucket[bkNew];
+
+          markIdx[idx] = bkNew;
+          vecBucketSortIntervalle[bkOld].start++;
+          bucketSortInfo &currB = vecBucketSortIntervalle[bkNew];
+
+          assert(distrib[currB.end].size() < distrib[currB.end].capacity());
+          distrib[currB.end++].push_(l);
+        }
       }
     }
 
@@ -177,6 +180,8 @@ template<class T> class BucketManager : public BucketManagerInterface<T>
   }
 
   vec<int> mustUnMark;
+  vec<uint64_t> residualClauses;
+  vec<char> compressedData;
   inline void resetUnMark()
   {
     for(int i = 0 ; i<mustUnMark.size() ; i++) markView[mustUnMark[i]] = false;
@@ -337,6 +342,54 @@ template<class T> class BucketManager : public BucketManagerInterface<T>
   } // storeClauses
 
 
+  /**
+     Transfer the formula store in distrib in a compressed key (see
+     CompressedKey), the clauses are taken in the same order as
+     storeClauses.
+
+     @param[in] component, the input variables
+     @param[out] b, the bucket
+     @param[in] nbLit, nbClause, the size of the formula
+  */
+  inline void storeCompressedFormula(vec<Var> &component, CacheBucket<T> &b, unsigned nbLit, unsigned nbClause)
+  {
+    compressedData.setSize(0);
+
+    Var prev = -1;
+    for(int i = 0 ; i<component.size() ; i++)
+    {
+      CompressedKey::putVarint(compressedData, CompressedKey::zigzag(component[i] - prev - 1));
+      prev = component[i];
+      mapVar[component[i]] = i;
+    }
+
+    for(int i = 0 ; i<=lastSize ; i++)
+    {
+      if(!distribClauseNbVar[i]) continue;
+      CompressedKey::putVarint(compressedData, distribClauseNbVar[i]);
+      CompressedKey::putVarint(compressedData, i);
+    }
+
+    CompressedKey::BitWriter bw(compressedData, CompressedKey::nbBitsLit(component.size()));
+    for(int i = 0 ; i<=lastSize ; i++)
+    {
+      if(!distribClauseNbVar[i]) continue;
+
+      for(int j = 0 ; j<distrib.size() ; j++)
+      {
+        if(distrib[j].size() != i) continue;
+        for(int k = 0 ; k<distrib[j].size() ; k++)
+          bw.put((mapVar[var(distrib[j][k])] << 1) | sign(distrib[j][k]));
+      }
+    }
+    bw.flush();
+
+    char *data = this->getArray(compressedData.size());
+    memcpy(data, (char *) compressedData, compressedData.size());
+    b.set(data, compressedData.size(), component.size(), nbLit, nbClause, 0, 0, COMPRESSED_KEY, 0);
+  }// storeCompressedFormula
+
+
   /**
      Transfer the formula store in distib in a table given in parameter.
 
@@ -352,6 +405,12 @@ template<class T> class BucketManager : public BucketManagerInterface<T>
     lastSize = 0;
     unsigned nbLit = 0, nbDiffSize = 0, nbClause = 0, maxDistribSz = 0;
     getInfoClDistrib(nbLit, nbDiffSize, nbClause, maxDistribSz);
+    if(BucketManagerInterface<T>::modeRepr == REPR_CP)
+    {
+      storeCompressedFormula(component, b, nbLit, nbClause);
+      for(int i = 0 ; i <= lastSize ; i++) distribClauseNbVar[i] = 0;
+      return;
+    }
 
     unsigned int nbOVar = this->nbOctetToEncodeInt(component.last() + 1);
     unsigned int nbOData = this->nbOctetToEncodeInt((component.size() + 2) << 1);
@@ -401,6 +460,56 @@ template<class T> class BucketManager : public BucketManagerInterface<T>
   }// storeFormula
 
 
+  /**
+     Compute the signature of the formula storeFormula would build,
+     without building it: the sum of the Zobrist keys of the variables
+     and of the residual clauses (the residual hash of the clauses is
+     maintained by the occurrence manager). As storeFormula, identical
+     residual clauses are only counted once.
+
+     @param[in] component, the variable belonging to the connected component
+     \return the signature (never 0)
+  */
+  uint64_t computeSignature(vec<Var> &component)
+  {
+    uint64_t sig = 0;
+    for(int i = 0 ; i<component.size() ; i++) sig += HashCnf::zobristVar(component[i]);
+
+    residualClauses.setSize(0);
+    for(int i = 0 ; i<component.size() ; i++)
+    {
+      if(occManager->varIsAssigned(component[i])) continue;
+
+      for(int s = 0 ; s<2 ; s++)
+      {
+        for(int b = 0 ; b<(BucketManagerInterface<T>::modeStore == NB ? 1 : 2) ; b++)
+        {
+          Lit l = mkLit(component[i], s);
+          VecView<int> idxClauses = b ? occManager->getVecIdxBinaryClause(l) : occManager->getVecIdxClause(l);
+          for(int j = 0 ; j<idxClauses.size() ; j++)
+          {
+            int idx = idxClauses[j];
+            if(markView[idx]) continue;
+            if(BucketManagerInterface<T>::modeStore == NT && !occManager->getNbUnsat(idx)) continue;
+            if(BucketManagerInterface<T>::modeStore == NB && occManager->getSizeClause(idx) <= 2) continue;
+
+            markView[idx] = true;
+            mustUnMark.push(idx);
+            residualClauses.push(occManager->getResidualHash(idx));
+          }
+        }
+      }
+    }
+    resetUnMark();
+
+    sort(residualClauses);
+    for(int i = 0 ; i<residualClauses.size() ; i++)
+      if(!i || residualClauses[i] != residualClauses[i - 1]) sig += HashCnf::zobristClause(residualClauses[i]);
+
+    return sig ? sig : 1;
+  }// computeSignature
+
+
  public:
   /**
      Function called in order to initialized variables before using
@@ -419,7 +528,6 @@ template<class T> class BucketManager : public BucketManagerInterface<T>
     BucketManagerInterface<T>::modeStore = NT;
     tmpKey = NULL;
     assert(occM);
-    strategyCache = strCache;
 
     assert(occM->getNbClause() <= nbClause);
     updateOccManager(nbClause, nbVar, maxSizeClause);
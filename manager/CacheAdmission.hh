@@ -0,0 +1,115 @@
+/*
+* d4
+* Copyright (C) 2020  Univ. Artois & CNRS
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef MANAGER_CACHE_ADMISSION
+#define MANAGER_CACHE_ADMISSION
+
+#include <vector>
+
+#include "../interfaces/CacheAdmissionInterface.hh"
+
+#define LOG_SIZE_DOORKEEPER 16 // bits per shard
+#define LOG_SIZE_SKETCH 12     // counters per row and per shard
+#define NB_ROW_SKETCH 4
+#define MAX_SKETCH_COUNT 15
+
+
+/**
+   Store a formula the second time it is missed: the formulas missed
+   once are remembered in a bit array indexed by the fingerprint, which
+   is cleared when half of the bits are set.
+ */
+class SecondMissAdmission : public CacheAdmissionInterface
+{
+  std::vector<uint64_t> bits;
+  unsigned nbSet;
+
+public:
+  SecondMissAdmission(int minVar, int maxVar) : CacheAdmissionInterface(minVar, maxVar)
+  {
+    bits.assign((1 << LOG_SIZE_DOORKEEPER) / 64, 0);
+    nbSet = 0;
+  }
+
+  bool admitFormula(uint64_t fp)
+  {
+    unsigned idx = fp & ((1 << LOG_SIZE_DOORKEEPER) - 1);
+    uint64_t &w = bits[idx >> 6], b = 1ULL << (idx & 63);
+    if(w & b) return true;
+
+    w |= b;
+    if(++nbSet > (1 << (LOG_SIZE_DOORKEEPER - 1)))
+    {
+      bits.assign(bits.size(), 0);
+      nbSet = 0;
+    }
+    return false;
+  }// admitFormula
+};
+
+
+/**
+   TinyLFU-like policy: the number of searches of each formula is
+   estimated with a count-min sketch (4-bit counters, all of them
+   halved after 10 searches per counter so that the old searches are
+   forgotten), and a formula is stored when it has been searched at
+   least minFreq times.
+ */
+class FrequencyAdmission : public CacheAdmissionInterface
+{
+  std::vector<unsigned char> counters;
+  unsigned nbAccess, minFreq;
+
+  inline unsigned char &counter(uint64_t fp, int row)
+  {
+    unsigned idx = (fp >> (row * LOG_SIZE_SKETCH)) & ((1 << LOG_SIZE_SKETCH) - 1);
+    return counters[(row << LOG_SIZE_SKETCH) | idx];
+  }// counter
+
+public:
+  FrequencyAdmission(int minVar, int maxVar, unsigned _minFreq = 2) :
+    CacheAdmissionInterface(minVar, maxVar), minFreq(_minFreq)
+  {
+    counters.assign(NB_ROW_SKETCH << LOG_SIZE_SKETCH, 0);
+    nbAccess = 0;
+  }
+
+  unsigned estimate(uint64_t fp)
+  {
+    unsigned f = MAX_SKETCH_COUNT;
+    for(int r = 0 ; r<NB_ROW_SKETCH ; r++) if(counter(fp, r) < f) f = counter(fp, r);
+    return f;
+  }// estimate
+
+  void recordAccess(uint64_t fp)
+  {
+    // conservative update: only the smallest counters are incremented
+    unsigned f = estimate(fp);
+    if(f < MAX_SKETCH_COUNT)
+      for(int r = 0 ; r<NB_ROW_SKETCH ; r++) if(counter(fp, r) == f) counter(fp, r)++;
+
+    if(++nbAccess >= 10 << LOG_SIZE_SKETCH)
+    {
+      for(unsigned i = 0 ; i<counters.size() ; i++) counters[i] >>= 1;
+      nbAccess >>= 1;
+    }
+  }// recordAccess
+
+  bool admitFormula(uint64_t fp){return estimate(fp) >= minFreq;}
+};
+
+#endif
@@ -22,6 +22,10 @@
 #include <cstdint>
 #include <math.h>
 
+// nbOctetsVar of the keys built with the compressed representation (the
+// other keys use 1, 2 or 4 octets, stored as 1, 2 and 0)
+#define COMPRESSED_KEY 3
+
 class DataInfo
 {
  private:
@@ -52,8 +56,8 @@ class DataInfo
            )
   {
     info1 = ((uint64_t) nbVar) | ((uint64_t) nbLit << 24) | ((uint64_t) nbClause << 48);
-    info2 = ((uint32_t) nbOctetsData) | ((uint32_t) nbOctetsVar << 2) |
-            ((uint32_t) nbOctetsDistrib << 4) | ((uint32_t) szData << 6);
+    info2 = ((uint32_t) nbOctetsData & 3) | (((uint32_t) nbOctetsVar & 3) << 2) |
+            (((uint32_t) nbOctetsDistrib & 3) << 4) | ((uint32_t) szData << 6);
     stats = {(unsigned) nbVar, 0};
   }
 
@@ -66,11 +70,15 @@ class DataInfo
   unsigned nbLit(){return info1>>24 & ((1<<24) - 1);}
   unsigned nbVar(){return info1 & ((1<<24) - 1);}
 
+  static unsigned octets(unsigned v){return v ? v : 4;}
+  bool compressed(){return nbOctetsVar() == COMPRESSED_KEY;}
+
   // need to be computed
   unsigned nbDiffSize()
   {
-    if(!nbOctetsDistrib()) return 0;
-    return (szData() - nbLit() * nbOctetsData() - nbVar() * nbOctetsVar()) / nbOctetsDistrib();
+    if(compressed()) return 0;
+    return (szData() - nbLit() * octets(nbOctetsData()) - nbVar() * octets(nbOctetsVar())) /
+      octets(nbOctetsDistrib());
   }
 
   inline void reinitCount(int v = 0) {stats.count = v;}
@@ -164,33 +172,37 @@ public:
            header.szData(), header.nbVar(), header.nbClause(), header.nbLit(),
            header.nbDiffSize(), header.count(), header.dirty());
 
-    // print the variable
-    printf("Var: %d(%d)\n", header.nbVar(), header.nbOctetsVar());
-    switch(header.nbOctetsVar())
-    {
-      case 1 : printData<char>(data, header.nbVar()); break;
-      case 2 : printData<char16_t>(data, header.nbVar()); break;
-      default : printData<char32_t>(data, header.nbVar()); break;
-    }
-
-    // distribution
-    char *dataDistrib = &data[header.nbVar() * header.nbOctetsVar()];
-    printf("Distribution: %d(%d)\n", header.nbDiffSize(), header.nbOctetsDistrib());
-    switch(header.nbOctetsDistrib())
-    {
-      case 1 : printData<char>(dataDistrib, header.nbDiffSize()); break;
-      case 2 : printData<char16_t>(dataDistrib, header.nbDiffSize()); break;
-      default : printData<char32_t>(dataDistrib, header.nbDiffSize()); break;
-    }
-
-    char *dataClause = &dataDistrib[header.nbDiffSize() * header.nbOctetsDistrib()];
-
-    printf("Clause: %d(%d)\n", header.nbClause(), header.nbOctetsData());
-    switch(header.nbOctetsData())
+    if(header.compressed()) printf("Compressed key (see CompressedKey)\n");
+    else
     {
-      case 1 : printData<char>(dataClause, &data[header.szData()] - dataClause); break;
-      case 2 : printData<char16_t>(dataClause, &data[header.szData()] - dataClause); break;
-      default : printData<char32_t>(dataClause, &data[header.szData()] - dataClause); break;
+      // print the variable
+      printf("Var: %d(%d)\n", header.nbVar(), header.nbOctetsVar());
+      switch(header.nbOctetsVar())
+      {
+        case 1 : printData<char>(data, header.nbVar()); break;
+        case 2 : printData<char16_t>(data, header.nbVar()); break;
+        default : printData<char32_t>(data, header.nbVar()); break;
+      }
+
+      // distribution
+      char *dataDistrib = &data[header.nbVar() * DataInfo::octets(header.nbOctetsVar())];
+      printf("Distribution: %d(%d)\n", header.nbDiffSize(), header.nbOctetsDistrib());
+      switch(header.nbOctetsDistrib())
+      {
+        case 1 : printData<char>(dataDistrib, header.nbDiffSize()); break;
+        case 2 : printData<char16_t>(dataDistrib, header.nbDiffSize()); break;
+        default : printData<char32_t>(dataDistrib, header.nbDiffSize()); break;
+      }
+
+      char *dataClause = &dataDistrib[header.nbDiffSize() * DataInfo::octets(header.nbOctetsDistrib())];
+
+      printf("Clause: %d(%d)\n", header.nbClause(), header.nbOctetsData());
+      switch(header.nbOctetsData())
+      {
+        case 1 : printData<char>(dataClause, &data[header.szData()] - dataClause); break;
+        case 2 : printData<char16_t>(dataClause, &data[header.szData()] - dataClause); break;
+        default : printData<char32_t>(dataClause, &data[header.szData()] - dataClause); break;
+      }
     }
 
     printf("All data: ");
@@ -26,10 +26,21 @@
 
 #include <string.h>
 #include <vector>
+#include <mutex>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "../manager/BucketManager.hh"
 #include "../manager/CacheBucket.hh"
+#include "../manager/PersistentCache.hh"
+#include "../manager/CompressedKey.hh"
 #include "../hashing/HashCnf.hh"
+#include "../hashing/KeyCompare.hh"
+#include "../interfaces/CacheAdmissionInterface.hh"
 
 #define GET_NB_CL(x)  ((((unsigned long int) x)>>44) & 1048575) // | 20 |    |    |   |
 #define GET_NB_LIT(x) ((((unsigned long int) x)>>24) & 1048575) // |    | 20 |    |   |
@@ -45,20 +56,24 @@
 #define BLOCK_BUFFER_INFO (1<<20)
 #define BLOCK_BUFFER_FORM (1<<20)
 
-#define SIZE_HASH 999331
-
 #define BUDGET 7
 
+#define NB_CACHE_SHARD 64
+#define LOG_NB_CACHE_SHARD 6
+#define INIT_SIZE_SHARD (1<<10)
+#define SIZE_GHOST_SHARD (1<<12)
+#define MAX_CREDIT_ENTRY 255
+
 template<class T> class TmpEntry
 {
  public:
   CacheBucket<T> e;
-  unsigned int hashValue;
+  uint64_t hashValue;
   bool defined;
 
   TmpEntry() { defined = false; }
 
-  TmpEntry(CacheBucket<T> e_, unsigned int hashValue_, bool defined_)
+  TmpEntry(CacheBucket<T> e_, uint64_t hashValue_, bool defined_)
   {
     e = e_;
     hashValue = hashValue_;
@@ -68,159 +83,930 @@ template<class T> class TmpEntry
   inline T getValue() {return e.fc;}
 };
 
+
+/**
+   A slot of the open addressing table: the fingerprint (the 64-bit
+   hash of the formula, 0 if the slot is empty) and the index of the
+   entry. Four slots fit in a cache line.
+ */
+struct CacheSlot
+{
+  uint64_t fingerprint;
+  unsigned idx;
+};
+
+
+/**
+   Information about an entry used by the eviction: its fingerprint
+   (to find its slot) and its credit for the CLOCK algorithm.
+ */
+struct CacheEntryInfo
+{
+  uint64_t fingerprint;
+  unsigned credit;
+};
+
+
+/**
+   A part of the cache with its own lock. The shard of an entry is
+   given by the highest bits of its hash, so that the workers sharing
+   the cache rarely wait for each other.
+
+   The entries are stored contiguously and indexed by an open
+   addressing table (linear probing) that keeps their fingerprint: the
+   data of an entry is only compared when the fingerprints are equal,
+   so a miss almost never reads a bucket. The table doubles when its
+   load factor reaches 0.7.
+
+   When the shard has a memory budget, the entries are evicted with
+   the CLOCK algorithm: an entry gets a credit of 1 + log2(#var) when
+   it is stored and each time it is hit (large components are more
+   expensive to compute again), the hand decrements the credits and
+   evicts the first entry without credit. The fingerprints of the
+   evicted entries are kept in a small direct-mapped table to count
+   the misses on formulas that were evicted.
+ */
+template<class T> class CacheShard
+{
+public:
+  std::mutex lock;
+  std::vector<CacheSlot> slots;
+  std::vector<CacheBucket<T> > entries;
+  std::vector<CacheEntryInfo> infos;
+  unsigned mask;
+
+  // eviction
+  unsigned long int memUsed, memBudget; // no budget if memBudget is 0
+  const char *mapBegin, *mapEnd;        // the data of a loaded cache file (not given back to a bucket manager)
+  unsigned hand;
+  std::vector<uint64_t> ghosts;
+
+  CacheAdmissionInterface *admission;
+
+  // statistics (modified under the lock)
+  int nbPositiveHit, nbNegativeHit;
+  unsigned long int nbCreationBucket, sumDataSize;
+  unsigned long int nbContention, nbDuplicateInsert;
+  unsigned long int nbFalseFingerprint, nbResize;
+  unsigned long int nbEviction, nbEvictionRun, nbReMiss;
+  unsigned long int nbEarlyMiss;
+
+  CacheShard()
+  {
+    nbPositiveHit = nbNegativeHit = 0;
+    nbCreationBucket = sumDataSize = nbContention = nbDuplicateInsert = 0;
+    nbFalseFingerprint = nbResize = 0;
+    nbEviction = nbEvictionRun = nbReMiss = 0;
+    nbEarlyMiss = 0;
+    memBudget = 0;
+    mapBegin = mapEnd = NULL;
+    admission = new CacheAdmissionInterface(0, 0);
+    initTable(INIT_SIZE_SHARD);
+  }
+
+  ~CacheShard(){delete admission;}
+
+  inline void acquire()
+  {
+    if(lock.try_lock()) return;
+    lock.lock();
+    nbContention++;
+  }// acquire
+
+  inline void release(){lock.unlock();}
+
+  // logical clock used to age the entries (local to the shard)
+  inline int clock(){return nbPositiveHit + nbNegativeHit;}
+
+  inline unsigned nbEntry(){return entries.size();}
+
+  /**
+     Empty the shard.
+
+     @param[in] capacity, the number of slots (a power of two)
+   */
+  inline void initTable(unsigned capacity)
+  {
+    entries.clear();
+    infos.clear();
+    slots.assign(capacity, CacheSlot{0, 0});
+    mask = capacity - 1;
+    memUsed = hand = 0;
+  }// initTable
+
+
+  /**
+     Set the memory budget of the shard.
+
+     @param[in] budget, the number of bytes the entries can use (0 for no limit)
+   */
+  inline void setMemoryBudget(unsigned long int budget)
+  {
+    memBudget = budget;
+    ghosts.assign(budget ? SIZE_GHOST_SHARD : 0, 0);
+  }// setMemoryBudget
+
+
+  /**
+     The memory taken by an entry: its data, the bucket, the
+     information for the eviction and (about) two slots.
+   */
+  static inline unsigned long int entryMemory(CacheBucket<T> &cb)
+  {
+    return cb.szData() + sizeof(CacheBucket<T>) + sizeof(CacheEntryInfo) + 2 * sizeof(CacheSlot);
+  }
+
+  /**
+     The credit given to an entry when it is stored or hit.
+   */
+  static inline unsigned entryWeight(CacheBucket<T> &cb)
+  {
+    unsigned w = 1;
+    for(int n = cb.nbVar() ; n > 1 ; n >>= 1) w++;
+    return w;
+  }// entryWeight
+
+
+  /**
+     Give credit to an entry of the shard that has been hit.
+
+     @param[in] cb, the entry
+   */
+  inline void touch(CacheBucket<T> *cb)
+  {
+    if(!memBudget) return;
+    CacheEntryInfo &info = infos[cb - entries.data()];
+    info.credit += entryWeight(*cb);
+    if(info.credit > MAX_CREDIT_ENTRY) info.credit = MAX_CREDIT_ENTRY;
+  }// touch
+
+
+  /**
+     Check if a missed formula has been evicted before (and forget it).
+
+     @param[in] fp, the fingerprint of the formula
+     \return true if the formula has been evicted
+   */
+  inline bool wasEvicted(uint64_t fp)
+  {
+    if(!memBudget) return false;
+    uint64_t &g = ghosts[fp & (SIZE_GHOST_SHARD - 1)];
+    if(g != fp) return false;
+    g = 0;
+    nbReMiss++;
+    return true;
+  }// wasEvicted
+
+
+  /**
+     Test if at least one entry has the given fingerprint.
+
+     @param[in] fp, the fingerprint
+     \return false if no stored formula can have this fingerprint
+   */
+  inline bool hasFingerprint(uint64_t fp)
+  {
+    for(unsigned pos = fp & mask ; slots[pos].fingerprint ; pos = (pos + 1) & mask)
+      if(slots[pos].fingerprint == fp) return true;
+    return false;
+  }// hasFingerprint
+
+
+  /**
+     Search the bucket.
+
+     @param[in] cb, the bucket we search
+     @param[in] fp, its fingerprint
+     \return the identical bucket if this one exists, NULL otherwise
+   */
+  inline CacheBucket<T> *find(CacheBucket<T> &cb, uint64_t fp)
+  {
+    for(unsigned pos = fp & mask ; slots[pos].fingerprint ; pos = (pos + 1) & mask)
+      {
+        if(slots[pos].fingerprint != fp) continue;
+
+        CacheBucket<T> &cbi = entries[slots[pos].idx];
+        if(cb.sameHeader(cbi) && KeyCompare::equal(cb.data, cbi.data, cbi.szData())) return &cbi;
+        nbFalseFingerprint++;
+      }
+    return NULL;
+  }// find
+
+
+  /**
+     Add a bucket (that is not already in the shard).
+
+     @param[in] cb, the bucket
+     @param[in] fp, its fingerprint
+     \return the bucket stored in the shard
+   */
+  inline CacheBucket<T> &insert(CacheBucket<T> &cb, uint64_t fp)
+  {
+    if((entries.size() + 1) * 10 > slots.size() * 7) grow();
+
+    unsigned pos = fp & mask;
+    while(slots[pos].fingerprint) pos = (pos + 1) & mask;
+    slots[pos] = CacheSlot{fp, (unsigned) entries.size()};
+
+    entries.push_back(cb);
+    infos.push_back(CacheEntryInfo{fp, entryWeight(cb)});
+    memUsed += entryMemory(cb);
+    return entries.back();
+  }// insert
+
+
+  /**
+     Remove the slot of the entry idx (backward shift deletion, the
+     following slots of the cluster are moved if they can be).
+
+     @param[in] fp, the fingerprint of the entry
+     @param[in] idx, the index of the entry
+   */
+  void eraseSlot(uint64_t fp, unsigned idx)
+  {
+    unsigned pos = fp & mask;
+    while(slots[pos].fingerprint != fp || slots[pos].idx != idx) pos = (pos + 1) & mask;
+
+    for(unsigned next = (pos + 1) & mask ; slots[next].fingerprint ; next = (next + 1) & mask)
+      {
+        unsigned home = slots[next].fingerprint & mask;
+        if(((next - home) & mask) < ((next - pos) & mask)) continue;
+        slots[pos] = slots[next];
+        pos = next;
+      }
+    slots[pos].fingerprint = 0;
+  }// eraseSlot
+
+
+  /**
+     Remove the entry idx, the last entry takes its place. The memory
+     of its data is given back to the bucket manager.
+
+     @param[in] idx, the index of the entry
+     @param[in] bm, the bucket manager
+   */
+  void removeEntry(unsigned idx, BucketManagerInterface<T> *bm)
+  {
+    CacheBucket<T> &cb = entries[idx];
+    uint64_t fp = infos[idx].fingerprint;
+
+    memUsed -= entryMemory(cb);
+    if(cb.data < mapBegin || cb.data >= mapEnd) bm->releaseMemory(cb.data, cb.szData());
+    ghosts[fp & (SIZE_GHOST_SHARD - 1)] = fp;
+    eraseSlot(fp, idx);
+
+    unsigned last = entries.size() - 1;
+    if(idx != last)
+      {
+        uint64_t fpLast = infos[last].fingerprint;
+        unsigned pos = fpLast & mask;
+        while(slots[pos].fingerprint != fpLast || slots[pos].idx != last) pos = (pos + 1) & mask;
+        slots[pos].idx = idx;
+
+        entries[idx] = entries[last];
+        infos[idx] = infos[last];
+      }
+
+    entries.pop_back();
+    infos.pop_back();
+    nbEviction++;
+  }// removeEntry
+
+
+  /**
+     Evict entries (CLOCK) until an entry of the given size can be
+     stored without exceeding the budget.
+
+     @param[in] need, the memory needed by the new entry
+     @param[in] bm, the bucket manager which gets back the memory
+   */
+  void makeRoom(unsigned long int need, BucketManagerInterface<T> *bm)
+  {
+    if(!memBudget || memUsed + need <= memBudget) return;
+
+    nbEvictionRun++;
+    while(entries.size() && memUsed + need > memBudget)
+      {
+        if(hand >= entries.size()) hand = 0;
+        if(infos[hand].credit){ infos[hand].credit--; hand++; }
+        else removeEntry(hand, bm);
+      }
+  }// makeRoom
+
+
+  /**
+     Double the size of the table.
+   */
+  void grow()
+  {
+    std::vector<CacheSlot> old;
+    old.swap(slots);
+    slots.assign(old.size() << 1, CacheSlot{0, 0});
+    mask = slots.size() - 1;
+    nbResize++;
+
+    for(unsigned i = 0 ; i<old.size() ; i++)
+      {
+        if(!old[i].fingerprint) continue;
+        unsigned pos = old[i].fingerprint & mask;
+        while(slots[pos].fingerprint) pos = (pos + 1) & mask;
+        slots[pos] = old[i];
+      }
+  }// grow
+};
+
+
 template<class T> class CacheCNF
 {
 public:
   bool verb;
-  std::vector< std::vector< CacheBucket<T> > > hashTable;
-  unsigned nbEntry;
+  bool shared;
+  CacheShard<T> *shards;
 
   // statistics
-  int nbPositiveHit, nbNegativeHit;
   double sumAffectedHitCache;
-  int minAffectedHitCache, nbReduceCall;
+  int minAffectedHitCache;
 
   // data info
   int nbInitVar;
   unsigned int maxBlockClause;
   unsigned int nbClauses;
-  vec<int> sizeVarCacheHit, nbCacheWithSizeVar, nbTestCache;
-  unsigned int nbFailedInCache, nbRemoveEntry;
-  unsigned long int nbCreationBucket;
+  // per size of the formulas (updated with atomic operations): the
+  // searches, the hits, the stored entries, the entries reused at
+  // least once and the formulas the admission policy did not store
+  vec<int> nbTestCache, nbHitWithSizeVar, nbCacheWithSizeVar, sizeVarCacheHit, nbRejectWithSizeVar;
+  unsigned int nbRemoveEntry;
 
   int maxSize;
   HashCnf hashMethod;
   int callReduceCache, strategyRedCache;
   vec<bool> deadSize;
-  unsigned long int sumDataSize;
+  unsigned long int memBudget;
+  char *mapData;          // the loaded cache file
+  size_t mapSize;
+
+  static inline void statInc(int &v){__atomic_fetch_add(&v, 1, __ATOMIC_RELAXED);}
+
+  inline CacheShard<T> &getShard(uint64_t hashValue){return shards[hashValue >> (64 - LOG_NB_CACHE_SHARD)];}
 
 public:
   CacheCNF(int rdCache, int strCache)
   {
-    sumDataSize = nbEntry = nbCreationBucket = 0;
+    shards = new CacheShard<T>[NB_CACHE_SHARD];
+    shared = false;
     strategyRedCache = strCache;
     callReduceCache = rdCache;
-    nbPositiveHit = nbNegativeHit = 0;
-    nbFailedInCache = 1;
-    nbRemoveEntry = nbReduceCall = sumAffectedHitCache = 0;
+    nbRemoveEntry = sumAffectedHitCache = 0;
+    memBudget = 0;
+    mapData = NULL;
+    mapSize = 0;
     verb = 0;
   }// CacheCNF
 
   ~CacheCNF()
   {
-    hashTable.clear();
+    delete[] shards;
+    if(mapData) munmap(mapData, mapSize);
+  }
+
+
+  /**
+     Write all the entries of the cache in a file: the header, then for
+     each entry its information, its key and its value.
+
+     @param[in] fileName, the file
+     @param[in] info, the header describing the current run
+     \return true if the file has been written
+   */
+  bool savePersistent(const char *fileName, PersistentCacheHeader &info)
+  {
+    FILE *f = fopen(fileName, "wb");
+    if(!f) return false;
+
+    info.nbEntry = getNbEntry();
+    bool ok = fwrite(&info, sizeof(PersistentCacheHeader), 1, f) == 1;
+
+    for(int s = 0 ; ok && s<NB_CACHE_SHARD ; s++)
+      for(unsigned i = 0 ; ok && i<shards[s].entries.size() ; i++)
+        {
+          CacheBucket<T> &cb = shards[s].entries[i];
+          std::string value = encodePersistentValue(cb.fc);
+          uint32_t szData = cb.szData(), szValue = value.size() + 1;
+
+          ok = fwrite(&cb.header, sizeof(DataInfo), 1, f) == 1 && fwrite(&szData, sizeof(uint32_t), 1, f) == 1 &&
+            fwrite(&szValue, sizeof(uint32_t), 1, f) == 1 && fwrite(cb.data, 1, szData, f) == szData &&
+            fwrite(value.c_str(), 1, szValue, f) == szValue;
+        }
+
+    return !fclose(f) && ok;
+  }// savePersistent
+
+
+  /**
+     Map a cache file in memory and add its entries to the cache. The
+     keys are not copied: the entries point into the mapping.
+
+     @param[in] fileName, the file
+     @param[in] info, the header describing the current run
+     @param[out] reason, the reason of the rejection if the file cannot be used
+     \return the number of entries added, -1 if the file is rejected
+   */
+  long int loadPersistent(const char *fileName, PersistentCacheHeader &info, const char *&reason)
+  {
+    assert(!mapData);
+    int fd = open(fileName, O_RDONLY);
+    if(fd < 0){ reason = "cannot open the file"; return -1; }
+
+    struct stat st;
+    if(fstat(fd, &st) || (size_t) st.st_size < sizeof(PersistentCacheHeader))
+    {
+      close(fd);
+      reason = "the file is truncated";
+      return -1;
+    }
+
+    mapSize = st.st_size;
+    mapData = (char *) mmap(NULL, mapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(mapData == MAP_FAILED){ mapData = NULL; reason = "cannot map the file"; return -1; }
+
+    PersistentCacheHeader fileInfo;
+    memcpy(&fileInfo, mapData, sizeof(PersistentCacheHeader));
+    if((reason = fileInfo.incompatibility(info)))
+    {
+      munmap(mapData, mapSize);
+      mapData = NULL;
+      return -1;
+    }
+
+    for(int s = 0 ; s<NB_CACHE_SHARD ; s++)
+    {
+      shards[s].mapBegin = mapData;
+      shards[s].mapEnd = mapData + mapSize;
+    }
+
+    long int nbLoaded = 0;
+    char *p = mapData + sizeof(PersistentCacheHeader), *end = mapData + mapSize;
+    for(uint64_t i = 0 ; i<fileInfo.nbEntry ; i++)
+    {
+      CacheBucket<T> cb;
+      uint32_t szData, szValue;
+      if(p + sizeof(DataInfo) + 2 * sizeof(uint32_t) > end) break;
+
+      memcpy(&cb.header, p, sizeof(DataInfo));
+      memcpy(&szData, p + sizeof(DataInfo), sizeof(uint32_t));
+      memcpy(&szValue, p + sizeof(DataInfo) + sizeof(uint32_t), sizeof(uint32_t));
+      p += sizeof(DataInfo) + 2 * sizeof(uint32_t);
+      if(p + szData + szValue > end || !szValue || p[szData + szValue - 1]) break;
+
+      cb.data = p;
+      cb.reinitDirty();
+      if(!decodePersistentValue(p + szData, cb.fc)) break;
+      p += szData + szValue;
+
+      uint64_t hashValue = computeHash(cb);
+      CacheShard<T> &shard = getShard(hashValue);
+      if(shard.find(cb, hashValue)) continue;
+      if(shard.memBudget && shard.memUsed + shard.entryMemory(cb) > shard.memBudget) continue;
+
+      CacheBucket<T> &cbIn = shard.insert(cb, hashValue);
+      cbIn.reinitCount(strategyRedCache ? shard.clock() : cb.nbVar());
+      statInc(nbCacheWithSizeVar[cb.nbVar()]);
+      nbLoaded++;
+    }
+
+    if(p != end) printf("c WARNING! The cache file %s is corrupted\n", fileName);
+    return nbLoaded;
+  }// loadPersistent
+
+  /**
+     Limit the memory used by the entries of the cache, the budget is
+     split between the shards.
+
+     @param[in] gb, the budget in GB (0 for no limit)
+   */
+  inline void setMemoryBudget(double gb)
+  {
+    memBudget = gb * (1UL << 30);
+    for(int i = 0 ; i<NB_CACHE_SHARD ; i++) shards[i].setMemoryBudget(memBudget / NB_CACHE_SHARD);
+  }// setMemoryBudget
+
+  /**
+     Select the formulas that are stored (see CacheAdmissionInterface).
+
+     @param[in] policy, the admission policy of the shards
+     @param[in] minVar, maxVar, the bounds on the number of variables of the stored formulas (0 for no limit)
+   */
+  inline void setAdmissionPolicy(const char *policy, int minVar, int maxVar)
+  {
+    for(int i = 0 ; i<NB_CACHE_SHARD ; i++)
+    {
+      delete shards[i].admission;
+      shards[i].admission = CacheAdmissionInterface::getAdmission(policy, minVar, maxVar);
+    }
+  }// setAdmissionPolicy
+
+  /**
+     Declare that several workers use this cache: an entry is then
+     only inserted if no other worker has already inserted it.
+   */
+  inline void setShared(bool b){shared = b;}
+
+  inline int getNbPositiveHit()
+  {
+    int nb = 0;
+    for(int i = 0 ; i<NB_CACHE_SHARD ; i++) nb += shards[i].nbPositiveHit;
+    return nb;
+  }
+
+  inline int getNbNegativeHit()
+  {
+    int nb = 0;
+    for(int i = 0 ; i<NB_CACHE_SHARD ; i++) nb += shards[i].nbNegativeHit;
+    return nb;
+  }
+
+  inline unsigned long int getNbContention()
+  {
+    unsigned long int nb = 0;
+    for(int i = 0 ; i<NB_CACHE_SHARD ; i++) nb += shards[i].nbContention;
+    return nb;
+  }
+
+  inline unsigned long int getNbDuplicateInsert()
+  {
+    unsigned long int nb = 0;
+    for(int i = 0 ; i<NB_CACHE_SHARD ; i++) nb += shards[i].nbDuplicateInsert;
+    return nb;
+  }
+
+  inline unsigned long int getNbFalseFingerprint()
+  {
+    unsigned long int nb = 0;
+    for(int i = 0 ; i<NB_CACHE_SHARD ; i++) nb += shards[i].nbFalseFingerprint;
+    return nb;
   }
 
-  inline int getNbPositiveHit(){return nbPositiveHit;}
-  inline int getNbNegativeHit(){return nbNegativeHit;}
+  inline unsigned long int getNbEntry()
+  {
+    unsigned long int nb = 0;
+    for(int i = 0 ; i<NB_CACHE_SHARD ; i++) nb += shards[i].nbEntry();
+    return nb;
+  }
+
+  inline unsigned long int getNbReduceCall()
+  {
+    unsigned long int nb = 0;
+    for(int i = 0 ; i<NB_CACHE_SHARD ; i++) nb += shards[i].nbEvictionRun;
+    return nb;
+  }
+
+  inline unsigned long int getNbEviction()
+  {
+    unsigned long int nb = 0;
+    for(int i = 0 ; i<NB_CACHE_SHARD ; i++) nb += shards[i].nbEviction;
+    return nb;
+  }
+
+  inline unsigned long int getNbReMiss()
+  {
+    unsigned long int nb = 0;
+    for(int i = 0 ; i<NB_CACHE_SHARD ; i++) nb += shards[i].nbReMiss;
+    return nb;
+  }
+
+  inline unsigned long int getNbEarlyMiss()
+  {
+    unsigned long int nb = 0;
+    for(int i = 0 ; i<NB_CACHE_SHARD ; i++) nb += shards[i].nbEarlyMiss;
+    return nb;
+  }
+
+  inline unsigned long int getMemoryEntries()
+  {
+    unsigned long int nb = 0;
+    for(int i = 0 ; i<NB_CACHE_SHARD ; i++) nb += shards[i].memUsed;
+    return nb;
+  }
+
+  inline unsigned long int getNbSlot()
+  {
+    unsigned long int nb = 0;
+    for(int i = 0 ; i<NB_CACHE_SHARD ; i++) nb += shards[i].slots.size();
+    return nb;
+  }
+
+  /**
+     Print the statistics per number of variables of the formulas,
+     grouped by power of two.
+   */
+  inline void printSizeHistogram()
+  {
+    printf("c Cache usage w.r.t. the number of variables of the formulas:\n");
+    printf("c %15s %10s %10s %8s %10s %10s %10s\n", "#var", "#search", "#hit", "hitRate", "#stored",
+           "#reused", "#rejected");
+    for(int lo = 1 ; lo<nbTestCache.size() ; lo <<= 1)
+    {
+      long int search = 0, hit = 0, stored = 0, reused = 0, rejected = 0;
+      int hi = (lo << 1) - 1 < nbTestCache.size() ? (lo << 1) - 1 : nbTestCache.size() - 1;
+      for(int i = lo ; i<=hi ; i++)
+      {
+        search += nbTestCache[i];
+        hit += nbHitWithSizeVar[i];
+        stored += nbCacheWithSizeVar[i];
+        reused += sizeVarCacheHit[i];
+        rejected += nbRejectWithSizeVar[i];
+      }
+      if(!search && !stored) continue;
+
+      char range[32];
+      snprintf(range, sizeof(range), "%d-%d", lo, hi);
+      printf("c %15s %10ld %10ld %7.2f%% %10ld %10ld %10ld\n", range, search, hit,
+             search ? (100.0 * hit) / search : 0, stored, reused, rejected);
+    }
+  }// printSizeHistogram
+
 
   inline void printCacheInformation()
   {
+    int nbPositiveHit = getNbPositiveHit(), nbNegativeHit = getNbNegativeHit();
+
     printf("c \033[1m\033[34mCache Information\033[0m\n");
     printf("c Memory used: %.0f MB\n", memUsedPeak());
     printf("c\n");
     printf("c Number of positive hit: %d\n", nbPositiveHit);
     printf("c Number of negative hit: %d\n", nbNegativeHit);
-    printf("c Number of reduceCall: %d\n", nbReduceCall);
+    printf("c Number of reduceCall: %lu\n", getNbReduceCall());
+    printf("c Number of entries: %lu (%lu slots)\n", getNbEntry(), getNbSlot());
+    printf("c Number of fingerprint collisions: %lu\n", getNbFalseFingerprint());
+    printf("c Key comparison: %s\n", KeyCompare::nameEqual(KeyCompare::selectEqual()));
+    printf("c Number of misses detected without building the formula: %lu\n", getNbEarlyMiss());
+    printSizeHistogram();
+    SlabAllocator::global().printInformation();
+    if(memBudget)
+    {
+      printf("c Memory used by the entries: %.1f MB (budget: %.1f MB)\n",
+             getMemoryEntries() / (double) (1<<20), memBudget / (double) (1<<20));
+      printf("c Number of evicted entries: %lu\n", getNbEviction());
+      printf("c Number of misses on evicted entries: %lu\n", getNbReMiss());
+    }
+    if(shared)
+    {
+      printf("c Hit rate: %.2lf%%\n", (nbPositiveHit + nbNegativeHit) ?
+             (100.0 * nbPositiveHit) / (nbPositiveHit + nbNegativeHit) : 0);
+      printf("c Number of contended shard locks: %lu\n", getNbContention());
+      printf("c Number of entries already inserted by another worker: %lu\n", getNbDuplicateInsert());
+    }
     printf("c\n");
   }// printCacheInformation
 
 
-  inline void pushInHashTable(CacheBucket<T> &cb, unsigned int hashValue, T val)
+  /**
+     Push a new entry (the lock of the shard is held by the caller).
+   */
+  inline void pushInHashTable(CacheShard<T> &shard, CacheBucket<T> &cb, uint64_t hashValue, T val,
+                              BucketManagerInterface<T> *bm)
   {
-    hashTable[hashValue % SIZE_HASH].push_back(cb);
-
-    CacheBucket<T> &cbIn = (hashTable[hashValue % SIZE_HASH].back());
+    shard.makeRoom(shard.entryMemory(cb), bm);
+    CacheBucket<T> &cbIn = shard.insert(cb, hashValue);
     cbIn.lockedBucket(val);
-    nbCreationBucket++;
-    sumDataSize += cb.szData();
+    shard.nbCreationBucket++;
+    shard.sumDataSize += cb.szData();
+    statInc(nbCacheWithSizeVar[cb.nbVar()]);
     
     switch(strategyRedCache)
     {
       case 0 : cbIn.reinitCount(cb.nbVar()); break;
       // case 0 : cbIn.reinitCount(nbPositiveHit + nbNegativeHit); break;
       case 1 : ;
-      case 2 : cbIn.reinitCount(nbPositiveHit + nbNegativeHit);
+      case 2 : cbIn.reinitCount(shard.clock());
     }
     assert(cbIn.count());
-    nbEntry++;
   }// pushinhashtable
 
 
-  inline unsigned int computeHash(CacheBucket<T> &bucket)
+  template <typename U> static inline unsigned readData(char *p, int i)
   {
-    return hashMethod.hash(bucket.data, bucket.szData());
+    U v;
+    memcpy(&v, p + i * sizeof(U), sizeof(U));
+    return v;
   }
 
+  static inline unsigned readData(char *p, int i, unsigned nbOctets)
+  {
+    switch(nbOctets)
+    {
+      case 1 : return readData<unsigned char>(p, i);
+      case 2 : return readData<char16_t>(p, i);
+      default : return readData<char32_t>(p, i);
+    }
+  }// readData
+
   /**
-     Research in the set of buckets if the bucket pointed by i already exist.
-     @param[in] idx, the index of the researched bucket
-     \return the index of the identical bucket if this one exists, -1 otherwise
-  */
-  CacheBucket<T> *bucketAlreadyExist(CacheBucket<T> &cb, unsigned int hashValue)
+     Compute the fingerprint of a stored formula: the signature
+     BucketManager::computeSignature gives to the same formula,
+     computed from the encoding (never 0, which marks the empty
+     slots).
+   */
+  inline uint64_t computeHash(CacheBucket<T> &bucket)
   {
-    char *refData = cb.data;
-    std::vector<CacheBucket<T> > &listCollision = hashTable[hashValue % SIZE_HASH];
+    DataInfo &h = bucket.header;
+    if(h.compressed()) return computeHashCompressed(bucket);
 
-    for(int i = 0 ; i<listCollision.size() ; i++)
+    unsigned nbVar = h.nbVar(), nbOVar = DataInfo::octets(h.nbOctetsVar());
+    unsigned nbODist = DataInfo::octets(h.nbOctetsDistrib()), nbOData = DataInfo::octets(h.nbOctetsData());
+    char *p = bucket.data, *distrib = p + nbVar * nbOVar;
+    char *cls = distrib + h.nbDiffSize() * nbODist;
+
+    uint64_t sig = 0;
+    for(unsigned i = 0 ; i<nbVar ; i++) sig += HashCnf::zobristVar(readData(p, i, nbOVar));
+
+    int pos = 0;
+    for(unsigned i = 0 ; i + 1<h.nbDiffSize() ; i += 2)
+    {
+      unsigned nbClause = readData(distrib, i, nbODist), sz = readData(distrib, i + 1, nbODist);
+      for(unsigned j = 0 ; j<nbClause ; j++)
       {
-        CacheBucket<T> &cbi = listCollision[i];
-        if(!cb.sameHeader(cbi)) continue;
+        uint64_t residual = 0;
+        for(unsigned k = 0 ; k<sz ; k++, pos++)
+        {
+          unsigned l = readData(cls, pos, nbOData);
+          residual ^= HashCnf::zobristLit((readData(p, l >> 1, nbOVar) << 1) | (l & 1));
+        }
+        sig += HashCnf::zobristClause(residual);
+      }
+    }
+
+    return sig ? sig : 1;
+  }// computeHash
+
+  /**
+     Same as computeHash for the keys of the compressed representation.
+   */
+  inline uint64_t computeHashCompressed(CacheBucket<T> &bucket)
+  {
+    DataInfo &h = bucket.header;
+    const char *p = bucket.data;
+
+    vec<Var> vars;
+    uint64_t sig = 0;
+    Var prev = -1;
+    for(unsigned i = 0 ; i<h.nbVar() ; i++)
+    {
+      vars.push(prev + 1 + CompressedKey::unzigzag(CompressedKey::getVarint(p)));
+      prev = vars.last();
+      sig += HashCnf::zobristVar(vars.last());
+    }
 
-        if(!memcmp(refData, cbi.data, cbi.szData()))
+    vec<unsigned> distrib;
+    for(unsigned nbClause = 0 ; nbClause<h.nbClause() ; nbClause += distrib[distrib.size() - 2])
+    {
+      distrib.push(CompressedKey::getVarint(p));
+      distrib.push(CompressedKey::getVarint(p));
+    }
+
+    CompressedKey::BitReader br(p, CompressedKey::nbBitsLit(h.nbVar()));
+    for(int i = 0 ; i<distrib.size() ; i += 2)
+      for(unsigned j = 0 ; j<distrib[i] ; j++)
+      {
+        uint64_t residual = 0;
+        for(unsigned k = 0 ; k<distrib[i + 1] ; k++)
         {
-          if(!cbi.dirty()) sizeVarCacheHit[cbi.nbVar()]++;
-          cbi.setTrueDirty();
-          nbPositiveHit++;
-          return &cbi;
+          unsigned l = br.get();
+          residual ^= HashCnf::zobristLit((vars[l >> 1] << 1) | (l & 1));
         }
+        sig += HashCnf::zobristClause(residual);
       }
-    nbNegativeHit++;
-    return NULL;
+
+    return sig ? sig : 1;
+  }// computeHashCompressed
+
+  /**
+     Research in the set of buckets if the bucket pointed by i already
+     exist (the lock of the shard is held by the caller).
+
+     \return the identical bucket if this one exists, NULL otherwise
+  */
+  CacheBucket<T> *bucketAlreadyExist(CacheShard<T> &shard, CacheBucket<T> &cb, uint64_t hashValue)
+  {
+    CacheBucket<T> *cbi = shard.find(cb, hashValue);
+    if(!cbi)
+    {
+      shard.nbNegativeHit++;
+      shard.wasEvicted(hashValue);
+      return NULL;
+    }
+    shard.touch(cbi);
+
+    statInc(nbHitWithSizeVar[cbi->nbVar()]);
+    if(!cbi->dirty()) statInc(sizeVarCacheHit[cbi->nbVar()]);
+    cbi->setTrueDirty();
+    shard.nbPositiveHit++;
+    return cbi;
   }// bucketAlreadyExist
 
 
   /**
-     Add an entry in the cache.
+     Add an entry in the cache. When the cache is shared, another
+     worker can have stored the same formula since our search: the
+     entry is then not inserted a second time and its memory is given
+     back to the bucket manager.
+
+     The formula is not stored if the admission policy of the shard
+     rejects it. When the search has been answered without building
+     the formula, the formula is built here (once admitted): the
+     residual formula must then be the one we searched.
+
+     @param[in] cb, the entry returned by searchInCache
+     @param[in] val, the value associated to the formula
+     @param[in] bm, the bucket manager that allocated the entry
+     @param[in] varConnected, the variables of the component
    */
-  void addInCache(TmpEntry<T> &cb, T val)
+  void addInCache(TmpEntry<T> &cb, T val, BucketManagerInterface<T> *bm, vec<Var> &varConnected)
   {
-    pushInHashTable(cb.e, cb.hashValue, val);
+    CacheShard<T> &shard = getShard(cb.hashValue);
+    shard.acquire();
+
+    if(!shard.admission->admit(cb.hashValue, varConnected.size()))
+    {
+      shard.release();
+      statInc(nbRejectWithSizeVar[varConnected.size()]);
+      if(cb.e.data) bm->releaseMemory(cb.e.data, cb.e.szData());
+      return;
+    }
+
+    if(!cb.e.data)
+    {
+      shard.release();
+      cb.e = *bm->collectBuckect(varConnected);
+      shard.acquire();
+    }
+
+    if(shared && shard.find(cb.e, cb.hashValue))
+    {
+      shard.nbDuplicateInsert++;
+      shard.release();
+      bm->releaseMemory(cb.e.data, cb.e.szData());
+      return;
+    }
+
+    pushInHashTable(shard, cb.e, cb.hashValue, val, bm);
+    shard.release();
   } // addInCache
 
   
   /**
      Take a bucket manager as well as a set of variables consisting in the
      variables in the current component and search in the cache if the related
-     formula is present in the cache, if it is not the case the bucket is
-     created and added.
+     formula is present in the cache. The signature of the formula is
+     maintained incrementally by the occurrence manager, then the
+     formula is only built when an entry has the same fingerprint (if
+     it is not the case, the returned entry has no data and addInCache
+     builds it).
 
      @param[in] varConnected, the variable
      @param[in] bm, the bucket manager
    */
   TmpEntry<T> searchInCache(vec<Var> &varConnected, BucketManagerInterface<T> *bm)
   {
-    CacheBucket<T> *formulaBucket = bm->collectBuckect(varConnected);
-    unsigned int hashValue = computeHash(*formulaBucket);
-    CacheBucket<T> *cacheBucket = bucketAlreadyExist(*formulaBucket, hashValue);
+    uint64_t hashValue = bm->computeSignature(varConnected);
     assert(nbTestCache.size() > varConnected.size());
-    nbTestCache[varConnected.size()]++;
+    statInc(nbTestCache[varConnected.size()]);
+
+    CacheShard<T> &shard = getShard(hashValue);
+    shard.acquire();
+    shard.admission->recordAccess(hashValue);
+    if(!shard.hasFingerprint(hashValue))
+    {
+      shard.nbNegativeHit++;
+      shard.nbEarlyMiss++;
+      shard.wasEvicted(hashValue);
+      shard.release();
+      return TmpEntry<T>(CacheBucket<T>(), hashValue, false);
+    }
+    shard.release();
+
+    CacheBucket<T> *formulaBucket = bm->collectBuckect(varConnected);
+    shard.acquire();
+    CacheBucket<T> *cacheBucket = bucketAlreadyExist(shard, *formulaBucket, hashValue);
 
     if(cacheBucket)
     {
       switch(strategyRedCache)
       {
-        case 1 : cacheBucket->reinitCount(nbPositiveHit + nbNegativeHit); break;
+        case 1 : cacheBucket->reinitCount(shard.clock()); break;
           // case 0 : cacheBucket->reinitCount(nbPositiveHit + nbNegativeHit); break;
         case 0 : cacheBucket->incCount(1); break;
       }
+      TmpEntry<T> ret(*cacheBucket, hashValue, true);
+      shard.release();
+
       bm->releaseMemory(formulaBucket->data, formulaBucket->szData());
-      return TmpEntry<T>(*cacheBucket, hashValue, true);
+      return ret;
     }
     else
     {
-      nbFailedInCache++;
-      nbCacheWithSizeVar[varConnected.size()]++;
+      shard.release();
       return TmpEntry<T>(*formulaBucket, hashValue, false);
     }
   } // searchInCache
@@ -235,10 +1021,13 @@ public:
    */
   inline void createAndStoreBucket(vec<Var> &varConnected, BucketManagerInterface<T> *bm, T &c)
   {
+    uint64_t hashValue = bm->computeSignature(varConnected);
     CacheBucket<T> *formulaBucket = bm->collectBuckect(varConnected);
-    unsigned int hashValue = computeHash(*formulaBucket);
-    pushInHashTable(*formulaBucket, hashValue, c); // add the new bucket
-    nbCacheWithSizeVar[varConnected.size()]++;
+
+    CacheShard<T> &shard = getShard(hashValue);
+    shard.acquire();
+    pushInHashTable(shard, *formulaBucket, hashValue, c, bm); // add the new bucket
+    shard.release();
   }// createBucket
 
 
@@ -261,9 +1050,11 @@ public:
 
     for(int i = 0 ; i<nbInitVar ; i++)
     {
-      sizeVarCacheHit.push(0);
-      nbCacheWithSizeVar.push(0);
       nbTestCache.push(0);
+      nbHitWithSizeVar.push(0);
+      nbCacheWithSizeVar.push(0);
+      sizeVarCacheHit.push(0);
+      nbRejectWithSizeVar.push(0);
       deadSize.push(false);
     }
   }// setInfoFormula
@@ -277,8 +1068,7 @@ public:
     setInfoFormula(mVar, nbC, mSize);
 
     // init hash tables
-    hashTable.clear();
-    for(int i = 0 ; i<SIZE_HASH ; i++) hashTable.push_back(std::vector<CacheBucket<T> >());
+    for(int i = 0 ; i<NB_CACHE_SHARD ; i++) shards[i].initTable(INIT_SIZE_SHARD);
   }// initHashTable
 
 
@@ -298,14 +1088,12 @@ public:
   {
     long int allC = 0;
     vec<int> countElt;
-    for(int i = 0 ; i<hashTable.size() ; i++)
-    {
-      for(int j = 0 ; j<hashTable[i].size() ; j++)
-      {
-        countElt.push(hashTable[i][j].count());
-        allC += hashTable[i][j].count();
-      }
-    }
+    for(int s = 0 ; s<NB_CACHE_SHARD ; s++)
+      for(unsigned i = 0 ; i<shards[s].entries.size() ; i++)
+        {
+          countElt.push(shards[s].entries[i].count());
+          allC += shards[s].entries[i].count();
+        }
     sort(countElt);
 
 
@@ -331,14 +1119,14 @@ public:
 
     return;
 
-    int biggestIdx = 0;
+    // distance between the slot of each entry and its initial position
     vec<int> tabDistrib;
-    for(int i = 0 ; i<hashTable.size() ; i++)
-      {
-        if(!hashTable[i].size()) continue;
-        tabDistrib.push(hashTable[i].size());
-        if(hashTable[biggestIdx].size() < hashTable[i].size()) biggestIdx = i;
-      }
+    for(int s = 0 ; s<NB_CACHE_SHARD ; s++)
+    {
+      CacheShard<T> &shard = shards[s];
+      for(unsigned i = 0 ; i<shard.slots.size() ; i++)
+        if(shard.slots[i].fingerprint) tabDistrib.push((i - shard.slots[i].fingerprint) & shard.mask);
+    }
 
     sort(tabDistrib);
     for(int i = 0 ; i<tabDistrib.size() ; i++) printf("%d ", tabDistrib[i]);
@@ -347,7 +1135,7 @@ public:
     float sum = 0;
     for(int i = 0 ; i<tabDistrib.size() ; i++) sum += tabDistrib[i];
 
-    printf("average size of conflict list %lf %d\n", ((float) sum) / tabDistrib.size(), tabDistrib.size());
+    printf("average probe length %lf %d\n", ((float) sum) / tabDistrib.size(), tabDistrib.size());
     printf("the median size is %d\n", tabDistrib[tabDistrib.size() >> 1]);
   }// showDistribution
 
@@ -23,27 +23,21 @@ using namespace std;
 /**
    Constructor.
  */
-CnfOccurrenceManager::CnfOccurrenceManager(int nbClause, int _nbVar, int _maxSizeClause) :
-    nbVar(_nbVar), maxSizeClause(_maxSizeClause)
+CnfOccurrenceManager::CnfOccurrenceManager(int nbClause, int _nbVar, int _maxSizeClause) : nbVar(_nbVar)
 {
+  nbVisit = nbAvoidedVisit = 0;
   for(int i = 0 ; i<nbVar ; i++)
     {
       inCurrentComponent.push(false);
       currentValue.push(l_Undef);
       idxComponent.push(0);
       tmpVecVar.push();
-      occList.push(); occList.push();
       tmpMark.push(false);
     }
 
-  mustUnMark.capacity(nbClause);
-  for(int i = 0 ; i<nbClause ; i++)
-    {
-      markView.push(false);
-      nbUnsat.push(0);
-      nbSat.push(0);
-      watcher.push(lit_Undef);
-    }
+  vec<vec<Lit> > noClause;
+  initFormula(noClause);
+  maxSizeClause = _maxSizeClause;
 }// construtor
 
 
@@ -52,6 +46,7 @@ CnfOccurrenceManager::CnfOccurrenceManager(int nbClause, int _nbVar, int _maxSiz
  */
 CnfOccurrenceManager::CnfOccurrenceManager(vec<vec<Lit> > &_clauses, int _nbVar) : nbVar(_nbVar)
 {
+  nbVisit = nbAvoidedVisit = 0;
   initFormula(_clauses);
 
   for(int i = 0 ; i<nbVar ; i++)
@@ -59,23 +54,9 @@ CnfOccurrenceManager::CnfOccurrenceManager(vec<vec<Lit> > &_clauses, int _nbVar)
       currentValue.push(l_Undef);
       idxComponent.push(0);
       tmpVecVar.push();
-      occList.push(); occList.push();
       tmpMark.push(false);
       inCurrentComponent.push(false);
     }
-
-  mustUnMark.capacity(clauses.size());
-
-  if(!clauses.size()) return;
-  maxSizeClause = clauses[0].size();
-  for(int i = 0 ; i<clauses.size() ; i++)
-    {
-      if(clauses[i].size() > maxSizeClause) maxSizeClause = clauses[i].size();
-      markView.push(false);
-      nbUnsat.push(0);
-      nbSat.push(0);
-      watcher.push(clauses[i][0]);
-    }
 }// construtor
 
 
@@ -87,14 +68,14 @@ int CnfOccurrenceManager::connectedToLit(Lit l, vec<int> &v, vec<Var> &varCompon
 {
   int cpt = 0;
 
-  vec<int> &occp = occList[toInt(l)];
+  VecView<int> occp = getVecIdxClause(l);
   for(int i = 0 ; i<occp.size() ; i++)
     {
-      vec<Lit> &c = clauses[occp[i]];
-      if(markView[occp[i]]) continue;
+      if(clauseInfo[occp[i]].markView) continue;
+      VecView<Lit> c = getClause(occp[i]);
 
       cpt++;
-      markView[occp[i]] = true;
+      clauseInfo[occp[i]].markView = true;
       mustUnMark.push_(occp[i]);
 
       // compute component
@@ -110,6 +91,18 @@ int CnfOccurrenceManager::connectedToLit(Lit l, vec<int> &v, vec<Var> &varCompon
             }
         }
     }
+
+  // the binary clauses give directly the other variable
+  VecView<Lit> implied = getBinaryImplication(l);
+  for(int i = 0 ; i<implied.size() ; i++)
+    {
+      Var vTmp = var(implied[i]);
+      if(currentValue[vTmp] == l_Undef && !v[vTmp])
+        {
+          varComponent.push_(vTmp);
+          v[vTmp] = nbComponent;
+        }
+    }
   return cpt;
 }// connectedToLit
 
@@ -118,6 +111,13 @@ int CnfOccurrenceManager::connectedToLit(Lit l, vec<int> &v, vec<Var> &varCompon
    Look all the formula in order to compute the connected component
    of the formula.
 
+   setOfVar is the component of the parent call, then the search never
+   leaves it. The breadth first search of a component stops as soon as
+   it has reached all the unassigned variables of setOfVar that are not
+   in a previous component: in the common case where the units do not
+   split the parent component, the occurrence lists of the last
+   variables found are not scanned.
+
    @param[out] varCo, the different connected components found
    @param[in] setOfVar, the current set of variables
    @param[out] freeVar, the set of variables that are present in setOfVar but not in the problem anymore
@@ -131,7 +131,10 @@ int CnfOccurrenceManager::computeConnectedComponent(vec< vec<Var> > &varCo, vec<
   freeVar.clear();
   int nbComponent = 0;
 
-  for(int i = 0 ; i<setOfVar.size() ; i++)
+  int nbRemaining = 0; // unassigned variables not yet in a component
+  for(int i = 0 ; i<setOfVar.size() ; i++) if(currentValue[setOfVar[i]] == l_Undef) nbRemaining++;
+
+  for(int i = 0 ; i<setOfVar.size() && nbRemaining ; i++)
     {
       Var v = setOfVar[i];
       if(currentValue[v] != l_Undef || idxComponent[v]) continue;
@@ -147,10 +150,20 @@ int CnfOccurrenceManager::computeConnectedComponent(vec< vec<Var> > &varCo, vec<
       int nbClausesInComponent = 0;
       for(int pos = 0 ; pos < tmpVecVar.size() ; pos++)
         {
+          if(tmpVecVar.size() == nbRemaining)
+            {
+              // all the remaining variables are in this component
+              for(int j = pos ; j<tmpVecVar.size() ; j++)
+                nbAvoidedVisit += getNbClause(mkLit(tmpVecVar[j], false)) + getNbClause(mkLit(tmpVecVar[j], true));
+              break;
+            }
+
           Lit l = mkLit(tmpVecVar[pos], false);
           nbClausesInComponent += connectedToLit(l, idxComponent, tmpVecVar, nbComponent);
           nbClausesInComponent += connectedToLit(~l, idxComponent, tmpVecVar, nbComponent);
+          nbVisit += getNbClause(l) + getNbClause(~l);
         }
+      nbRemaining -= tmpVecVar.size();
 
       if(tmpVecVar.size() <= 1)
         {
@@ -189,8 +202,8 @@ int CnfOccurrenceManager::computeConnectedComponent(vec< vec<Var> > &varCo, vec<
  */
 inline bool CnfOccurrenceManager::isSatisfiedClause(int idx)
 {
-  assert(idx < clauses.size());
-  return nbSat[idx];
+  assert(idx < getNbClause());
+  return clauseInfo[idx].nbSat;
 }// isSatisfiedClause
 
 
@@ -202,7 +215,7 @@ inline bool CnfOccurrenceManager::isSatisfiedClause(int idx)
 
    \return true if the clause is satisfied, false otherwise.
  */
-inline bool CnfOccurrenceManager::isSatisfiedClause(vec<Lit> &c)
+inline bool CnfOccurrenceManager::isSatisfiedClause(VecView<Lit> c)
 {
   for(int i = 0 ; i<c.size() ; i++)
     {
@@ -230,10 +243,11 @@ inline bool CnfOccurrenceManager::isSatisfiedClause(vec<Lit> &c)
  */
 inline bool CnfOccurrenceManager::isNotSatisfiedClauseAndInComponent(int idx, vec<bool> &inCurrentComponent)
 {
-  if(nbSat[idx]) return false;
-  assert(watcher[idx] != lit_Undef);
-  assert(!litIsAssigned(watcher[idx]));
-  return inCurrentComponent[var(watcher[idx])];
+  ClauseInfo &ci = clauseInfo[idx];
+  if(ci.nbSat) return false;
+  assert(ci.watcher != lit_Undef);
+  assert(!litIsAssigned(ci.watcher));
+  return inCurrentComponent[var(ci.watcher)];
 }// isSatisfiedClause
 
 
@@ -251,7 +265,7 @@ void CnfOccurrenceManager::getCurrentClauses(vec<int> &idxClauses, vec<bool> &in
   for(int i = 0 ; i<currentSize ; i++)
   {
     idxClauses.push(currentIdx[i]);
-    assert(!nbSat[currentIdx[i]]);
+    assert(!clauseInfo[currentIdx[i]].nbSat);
     assert(isNotSatisfiedClauseAndInComponent(currentIdx[i], inComponent));
   }
 
@@ -277,7 +291,7 @@ void CnfOccurrenceManager::updateCurrentClauseSet(vec<Var> &component)
     }
   }
 
-  for(int i = 0 ; i<currentSize ; i++) assert(!nbSat[currentIdx[i]]);
+  for(int i = 0 ; i<currentSize ; i++) assert(!clauseInfo[currentIdx[i]].nbSat);
   for(int i = 0 ; i<component.size() ; i++) inCurrentComponent[component[i]] = false;
 }// updatecurrentclauseset
 
@@ -22,20 +22,51 @@
 
 #include "../mtl/Alg.hh"
 #include "../mtl/Sort.hh"
+#include "../mtl/VecView.hh"
 #include "../interfaces/OccurrenceManagerInterface.hh"
 #include "../interfaces/BucketManagerInterface.hh"
+#include "../hashing/HashCnf.hh"
 
 using namespace std;
 
+/**
+   The clauses and the occurrence lists are stored in flat arrays
+   (compressed sparse rows): the literals of the clause idx are
+   lits[clauseStart[idx] .. clauseStart[idx + 1][. The occurrence lists
+   of the literal l are in occIdx[occStart[l] .. occStart[l + 1][,
+   which is cut in two parts whose capacities are the number of
+   occurrences of l in the formula:
+
+   - the clauses that are not binary, occIdx[occStart[l] ..
+     occStart[l] + occSize[l][;
+   - the binary clauses, occIdx[binStart[l] .. binStart[l] +
+     binSize[l][, with the other literal of the clause in binOther
+     (the implication graph of the binary clauses).
+
+   The counters of a clause that are updated together when a literal
+   is assigned are packed in a ClauseInfo. nbResidualBinary[l] is the
+   number of clauses of l with exactly two unassigned literals.
+ */
 class CnfOccurrenceManager : public OccurrenceManagerInterface
 {
 protected:
-  vec<vec<Lit> > clauses;
+  struct ClauseInfo
+  {
+    uint64_t residualHash; // xor of the Zobrist keys of the unassigned literals of the clause
+    int nbUnsat, nbSat;
+    Lit watcher;
+    bool markView, binary;
+  };
+
+  vec<Lit> lits;
+  vec<int> clauseStart;
+  vec<ClauseInfo> clauseInfo;
+  vec<int> occIdx, occStart, occSize, binStart, binSize;
+  vec<Lit> binOther;
+  vec<int> nbResidualBinary;
+
   int nbVar, maxSizeClause;
   vec<lbool> currentValue;
-  vec<int> nbUnsat;
-  vec<int> nbSat;
-  vec<Lit> watcher;
 
   vec<int> currentIdx;
   int currentSize;
@@ -44,24 +75,62 @@ protected:
 
   inline void showOccurenceList()
   {
-    for(int i = 0 ; i<occList.size() ; i++)
+    for(int i = 0 ; i<occSize.size() ; i++)
       {
         printf("%s%d: ", (i&1) ? "-" : "", (i>>1) + 1);
-        for(int j = 0 ; j<occList[i].size() ; j++) printf("%d ", occList[i][j]);
+        for(int b = 0 ; b<2 ; b++)
+          {
+            VecView<int> occ = b ? getVecIdxBinaryClause(toLit(i)) : getVecIdxClause(toLit(i));
+            for(int j = 0 ; j<occ.size() ; j++) printf("%d ", occ[j]);
+          }
         printf("\n");
       }
   }
 
+  /**
+     Add the clause idx at the end of the occurrence list of l.
+   */
+  inline void pushOccurrence(Lit l, int idx)
+  {
+    if(clauseInfo[idx].binary)
+      {
+        int pos = binStart[toInt(l)] + binSize[toInt(l)]++;
+        assert(pos < occStart[toInt(l) + 1]);
+        VecView<Lit> c = getClause(idx);
+        occIdx[pos] = idx;
+        binOther[pos] = c[0] == l ? c[1] : c[0];
+      }
+    else
+      {
+        assert(occStart[toInt(l)] + occSize[toInt(l)] < binStart[toInt(l)]);
+        occIdx[occStart[toInt(l)] + occSize[toInt(l)]++] = idx;
+      }
+  }// pushOccurrence
+
+  inline void clearOccurrence(Lit l){occSize[toInt(l)] = binSize[toInt(l)] = 0;}
+
+  /**
+     Add inc to nbResidualBinary for the unassigned literals of the
+     clause idx.
+   */
+  inline void updateResidualBinary(int idx, int inc)
+  {
+    VecView<Lit> c = getClause(idx);
+    for(int k = 0 ; k<c.size() ; k++)
+      if(currentValue[var(c[k])] == l_Undef) nbResidualBinary[toInt(c[k])] += inc;
+  }// updateResidualBinary
+
 protected:
   // to manage the connected component
   vec<int> mustUnMark;
   vec<Var> tmpVecVar;
   vec<int> idxComponent;
-  vec<bool> tmpMark, markView;
+  vec<bool> tmpMark;
+  unsigned long int nbVisit, nbAvoidedVisit; // occurrences scanned, and not scanned thanks to the early stop
 
   inline void resetUnMark()
   {
-    for(int i = 0 ; i<mustUnMark.size() ; i++) markView[mustUnMark[i]] = false;
+    for(int i = 0 ; i<mustUnMark.size() ; i++) clauseInfo[mustUnMark[i]].markView = false;
     mustUnMark.setSize(0);
   }// resetUnMark
 
@@ -74,46 +143,85 @@ public:
   int computeConnectedComponent(vec< vec<Var> > &varConnected, vec<Var> &setOfVar, vec<Var> &freeVar,
                                 vec<Var> &notFreeVar);
 
+  /**
+     Store a new set of clauses, the occurrence lists are allocated
+     but empty.
+   */
   inline void initFormula(vec<vec<Lit> > &_clauses)
   {
-    clauses.clear();
+    lits.clear();
+    clauseStart.clear();
+    clauseInfo.clear();
     currentIdx.clear();
-
+    maxSizeClause = 0;
+
+    occStart.clear();
+    occStart.growTo((nbVar << 1) + 1, 0);
+    binStart.clear();
+    binStart.growTo(nbVar << 1, 0);
+    nbResidualBinary.clear();
+    nbResidualBinary.growTo(nbVar << 1, 0);
     for(int i = 0 ; i<_clauses.size() ; i++)
       {
-        clauses.push();
-        assert(_clauses[i].size());
-        _clauses[i].copyTo(clauses.last());
+        vec<Lit> &c = _clauses[i];
+        assert(c.size());
+        clauseStart.push(lits.size());
         currentIdx.push(i);
+
+        ClauseInfo ci;
+        ci.residualHash = 0;
+        ci.nbUnsat = ci.nbSat = 0;
+        ci.watcher = c[0];
+        ci.markView = false;
+        ci.binary = c.size() == 2 && var(c[0]) != var(c[1]);
+        for(int j = 0 ; j<c.size() ; j++)
+          {
+            lits.push(c[j]);
+            occStart[toInt(c[j]) + 1]++;
+            if(ci.binary) binStart[toInt(c[j])]++, nbResidualBinary[toInt(c[j])]++;
+            ci.residualHash ^= HashCnf::zobristLit(toInt(c[j]));
+          }
+        clauseInfo.push(ci);
+        if(c.size() > maxSizeClause) maxSizeClause = c.size();
       }
+    clauseStart.push(lits.size());
+
+    // the binary clauses are at the end of the lists
+    for(int i = 1 ; i<occStart.size() ; i++) occStart[i] += occStart[i - 1];
+    for(int i = 0 ; i<binStart.size() ; i++) binStart[i] = occStart[i + 1] - binStart[i];
 
-    currentSize = clauses.size();
+    occIdx.clear();
+    occIdx.growTo(lits.size());
+    binOther.clear();
+    binOther.growTo(lits.size(), lit_Undef);
+    occSize.clear();
+    occSize.growTo(nbVar << 1, 0);
+    binSize.clear();
+    binSize.growTo(nbVar << 1, 0);
+
+    mustUnMark.clear();
+    mustUnMark.capacity(clauseInfo.size());
+
+    currentSize = clauseInfo.size();
     stackSize.clear();
     for(int i = 0 ; i<currentValue.size() ; i++) currentValue[i] = l_Undef;
   }// initFormula
 
-  inline int getNbBinaryClause(Lit l)
-  {
-    int nbBin = 0;
-
-    for(int i = 0 ; i<occList[toInt(l)].size() ; i++)
-      {
-        int idx = occList[toInt(l)][i];
-        if(clauses[idx].size() - nbUnsat[idx] == 2) nbBin++;
-      }
-
-    return nbBin;
-  }
+  inline int getNbBinaryClause(Lit l){return nbResidualBinary[toInt(l)];}
 
   inline void showOccList()
   {
-    for(int i = 0 ; i<occList.size() ; i++)
+    for(int i = 0 ; i<occSize.size() ; i++)
       {
         Lit l = mkLit(i>>1, i&1);
-        if(!occList[i].size()) continue;
+        if(!getNbClause(l)) continue;
 
         printf("%d: ", readableLit(l));
-        for(int j = 0 ; j<occList[i].size() ; j++) printf("%d ", occList[i][j]);
+        for(int b = 0 ; b<2 ; b++)
+          {
+            VecView<int> occ = b ? getVecIdxBinaryClause(l) : getVecIdxClause(l);
+            for(int j = 0 ; j<occ.size() ; j++) printf("%d ", occ[j]);
+          }
         printf("\n");
       }
   }
@@ -122,7 +230,12 @@ public:
   inline void showFormula()
   {
     printf("Occurrence Managaer: print formula\n");
-    for(int i = 0 ; i<clauses.size() ; i++) showListLit(clauses[i]);
+    for(int i = 0 ; i<getNbClause() ; i++)
+      {
+        VecView<Lit> c = getClause(i);
+        for(int j = 0 ; j<c.size() ; j++) printf("%d ", readableLit(c[j]));
+        printf("\n");
+      }
   }// showFormula
 
 
@@ -130,12 +243,21 @@ public:
   inline int getNbNotBinaryClause(Lit l){return getNbClause(l) - getNbBinaryClause(l);}
   inline int getNbNotBinaryClause(Var v){return getNbClause(v) - getNbBinaryClause(v);}
   inline int getNbClause(Var v){return getNbClause(mkLit(v, false)) + getNbClause(mkLit(v, true));}
-  inline int getNbClause(Lit l){return occList[toInt(l)].size();}
-  inline int getNbClause(){return clauses.size();}
-  inline vec<int> &getVecIdxClause(Lit l){return occList[toInt(l)];}
-  inline vec<Lit> &getClause(int idx){return clauses[idx];}
-  inline int getNbUnsat(int idx){return nbUnsat[idx];}
+  inline int getNbClause(Lit l){return occSize[toInt(l)] + binSize[toInt(l)];}
+  inline int getNbClause(){return clauseInfo.size();}
+  inline VecView<int> getVecIdxClause(Lit l){return VecView<int>((int *) occIdx + occStart[toInt(l)], occSize[toInt(l)]);}
+  inline VecView<int> getVecIdxBinaryClause(Lit l){return VecView<int>((int *) occIdx + binStart[toInt(l)], binSize[toInt(l)]);}
+  inline VecView<Lit> getBinaryImplication(Lit l){return VecView<Lit>((Lit *) binOther + binStart[toInt(l)], binSize[toInt(l)]);}
+  inline VecView<Lit> getClause(int idx)
+  {
+    return VecView<Lit>((Lit *) lits + clauseStart[idx], clauseStart[idx + 1] - clauseStart[idx]);
+  }
+  inline int getSizeClause(int idx){return clauseStart[idx + 1] - clauseStart[idx];}
+  inline int getNbUnsat(int idx){return clauseInfo[idx].nbUnsat;}
+  inline uint64_t getResidualHash(int idx){return clauseInfo[idx].residualHash;}
   inline int getNbVariable(){return nbVar;}
+  inline unsigned long int getNbComponentVisit(){return nbVisit;}
+  inline unsigned long int getNbAvoidedComponentVisit(){return nbAvoidedVisit;}
 
   inline bool litIsAssigned(Lit l){return currentValue[var(l)] != l_Undef;}
   inline bool litIsAssignedToTrue(Lit l)
@@ -147,15 +269,10 @@ public:
   inline bool varIsAssigned(Var v){return currentValue[v] != l_Undef;}
   inline int getMaxSizeClause(){return maxSizeClause;}
 
-  virtual inline int getSumSizeClauses()
-  {
-    int sum = 0;
-    for(int i = 0 ; i<clauses.size() ; i++) sum += clauses[i].size();
-    return sum;
-  }// getSumSizeClauses
+  virtual inline int getSumSizeClauses(){return lits.size();}
 
   bool isSatisfiedClause(int idx);
-  bool isSatisfiedClause(vec<Lit> &c);
+  bool isSatisfiedClause(VecView<Lit> c);
   bool isNotSatisfiedClauseAndInComponent(int idx, vec<bool> &inCurrentComponent);
 
 
@@ -164,8 +281,8 @@ public:
 
   inline bool byPass(int mode, int idx)
   {
-    if(mode >= NB && clauses[idx].size() <= 2) return true;
-    if(mode == NT && !nbUnsat[idx]) return true;
+    if(mode >= NB && getSizeClause(idx) <= 2) return true;
+    if(mode == NT && !clauseInfo[idx].nbUnsat) return true;
     return false;
   }
 
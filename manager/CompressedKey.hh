@@ -0,0 +1,113 @@
+/*
+* d4
+* Copyright (C) 2020  Univ. Artois & CNRS
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef MANAGER_COMPRESSEDKEY
+#define MANAGER_COMPRESSEDKEY
+
+#include <cstdint>
+
+#include "../mtl/Vec.hh"
+
+/**
+   Encoding of the cache keys of the compressed representation (-cr=CP).
+   The key stores the same formula as the CL representation, in the
+   same order:
+
+   - the variables, as varints of the zigzag encoded gaps
+     (v[i] - v[i-1] - 1), that is one octet per variable when the
+     component is dense;
+   - the distribution (number of clauses, size) as varints;
+   - the literals, numbered as in the CL representation
+     ((index of the variable << 1) | sign), bit-packed on the number of
+     bits needed for the component (see nbBitsLit).
+
+   The encoding of a formula is unique, then two keys can be compared
+   without being decoded.
+ */
+class CompressedKey
+{
+public:
+  static inline unsigned zigzag(int v){return ((unsigned) v << 1) ^ (unsigned) (v >> 31);}
+  static inline int unzigzag(unsigned v){return (int) (v >> 1) ^ -(int) (v & 1);}
+
+  static inline unsigned nbBitsLit(unsigned nbVar)
+  {
+    unsigned maxLit = nbVar ? ((nbVar - 1) << 1) | 1 : 1;
+    return 32 - __builtin_clz(maxLit);
+  }// nbBitsLit
+
+  static inline void putVarint(vec<char> &out, unsigned v)
+  {
+    for( ; v >= 0x80 ; v >>= 7) out.push((char) (v | 0x80));
+    out.push((char) v);
+  }// putVarint
+
+  static inline unsigned getVarint(const char *&p)
+  {
+    unsigned v = 0;
+    for(int shift = 0 ; ; shift += 7)
+    {
+      unsigned char c = *p++;
+      v |= (unsigned) (c & 0x7F) << shift;
+      if(!(c & 0x80)) return v;
+    }
+  }// getVarint
+
+
+  /**
+     Write integers of nbBits bits (less than 32), the first one in the
+     low-order bits of the first octet.
+   */
+  class BitWriter
+  {
+    vec<char> &out;
+    uint64_t acc;
+    unsigned nbAcc, nbBits;
+
+  public:
+    BitWriter(vec<char> &o, unsigned nb) : out(o), acc(0), nbAcc(0), nbBits(nb) {}
+
+    inline void put(unsigned v)
+    {
+      acc |= (uint64_t) v << nbAcc;
+      for(nbAcc += nbBits ; nbAcc >= 8 ; nbAcc -= 8, acc >>= 8) out.push((char) acc);
+    }
+
+    inline void flush(){if(nbAcc) out.push((char) acc); acc = nbAcc = 0;}
+  };
+
+  class BitReader
+  {
+    const unsigned char *p;
+    uint64_t acc;
+    unsigned nbAcc, nbBits;
+
+  public:
+    BitReader(const char *data, unsigned nb) : p((const unsigned char *) data), acc(0), nbAcc(0), nbBits(nb) {}
+
+    inline unsigned get()
+    {
+      for( ; nbAcc < nbBits ; nbAcc += 8) acc |= (uint64_t) *p++ << nbAcc;
+      unsigned v = acc & ((1ULL << nbBits) - 1);
+      acc >>= nbBits;
+      nbAcc -= nbBits;
+      return v;
+    }
+  };
+};
+
+#endif
@@ -33,18 +33,40 @@ public:
 
   int freqLimitDyn;
   int reduceCache, strategyRedCache;
+  int nbThreads, splitDepth, minVarParallel;
+  int cacheMinVar, cacheMaxVar;
+  double cacheMemory;
 
   const char *cacheStore;
   const char *varHeuristic;
   const char *phaseHeuristic;
   const char *partitionHeuristic;
+  const char *hypergraphPartitioner;
   const char *cacheRepresentation;
+  const char *parallelMode;
+  const char *cacheLoad, *cacheSave;
+  const char *cacheAdmission;
 
   OptionManager(int _optCache, bool _optAnd, bool _reversePolarity, bool _reducePrimalGraph,
                 bool _equivSimplification, const char *_cacheStore, const char *_varHeuristic,
                 const char *_phaseHeuristic, const char *_partitionHeuristic,
-                const char *_cacheRepresentation, int rdCache, int strCache, int frqLimit)
+                const char *_cacheRepresentation, int rdCache, int strCache, int frqLimit,
+                int _nbThreads = 1, int _splitDepth = 0, const char *_parallelMode = "CUBE",
+                int _minVarParallel = 32, double _cacheMemory = 0, const char *_cacheLoad = "",
+                const char *_cacheSave = "", const char *_cacheAdmission = "ALL", int _cacheMinVar = 0,
+                int _cacheMaxVar = 0, const char *_hypergraphPartitioner = "ML")
   {
+    hypergraphPartitioner = _hypergraphPartitioner;
+    cacheAdmission = _cacheAdmission;
+    cacheMinVar = _cacheMinVar;
+    cacheMaxVar = _cacheMaxVar;
+    cacheLoad = _cacheLoad;
+    cacheSave = _cacheSave;
+    cacheMemory = _cacheMemory;
+    nbThreads = _nbThreads;
+    splitDepth = _splitDepth;
+    parallelMode = _parallelMode;
+    minVarParallel = _minVarParallel;
     freqLimitDyn = frqLimit;
     strategyRedCache = strCache;
     reduceCache = rdCache;
@@ -67,13 +89,24 @@ public:
     printf("c Caching: %d\n", optCache);
     printf("c Reduce cache procedure level: %d\n", reduceCache);
     printf("c Strategy for Reducing the cache: %d\n", strategyRedCache);
+    if(cacheMemory > 0) printf("c Cache memory budget: %g GB\n", cacheMemory);
     printf("c Cache representation: %s\n", cacheRepresentation);
+    printf("c Cache admission policy: %s", cacheAdmission);
+    if(cacheMinVar) printf(" (at least %d variables)", cacheMinVar);
+    if(cacheMaxVar) printf(" (at most %d variables)", cacheMaxVar);
+    printf("\n");
     printf("c Part of the formula that is cached: %s\n", cacheStore);
     printf("c Variable heuristic: %s\n", varHeuristic);
     printf("c Phase heuristic: %s%s\n", (reversePolarity) ? "reverse " : "", phaseHeuristic);
-    printf("c Partitioning heuristic: %s%s%s\n", partitionHeuristic,
+    printf("c Partitioning heuristic: %s (%s)%s%s\n", partitionHeuristic, hypergraphPartitioner,
            (reducePrimalGraph) ? " + graph reduction" : "",
            (equivSimplification) ? " + equivalence simplication" : "");
+    if(nbThreads > 1)
+      {
+        printf("c Number of threads: %d\n", nbThreads);
+        printf("c Parallel mode: %s (split depth: %d, min component size: %d)\n", parallelMode,
+               splitDepth, minVarParallel);
+      }
     printf("c\n");
   }
 };
@@ -0,0 +1,120 @@
+/*
+* d4
+* Copyright (C) 2020  Univ. Artois & CNRS
+* 
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef MANAGER_PERSISTENT_CACHE
+#define MANAGER_PERSISTENT_CACHE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cstdint>
+#include <string>
+
+#include <boost/multiprecision/gmp.hpp>
+using namespace boost::multiprecision;
+
+#define PERSISTENT_CACHE_MAGIC "D4CACHE"
+#define PERSISTENT_CACHE_VERSION 1
+
+/**
+   Header of a cache file. A file is only reloaded when all the fields
+   are identical to the ones of the current run (except nbEntry):
+
+   - the keys are the bytes built by BucketManager::storeFormula, they
+     depend on the variable numbering (nbVar) and on the part of the
+     formula that is stored (modeStore) and on their encoding
+     (representation), and the keys built without
+     all the clauses (NB and NT) depend on the clause database
+     (formulaSignature, 0 when all the clauses are in the keys);
+   - the values are weighted counts (weightSignature covers the
+     weights and the projected variables, valueKind the number type).
+ */
+struct PersistentCacheHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t sizeInfo;
+  uint32_t valueKind;
+  uint32_t modeStore;
+  uint32_t nbVar;
+  uint32_t representation;
+  uint64_t formulaSignature;
+  uint64_t weightSignature;
+  uint64_t nbEntry;
+
+  PersistentCacheHeader()
+  {
+    memset(this, 0, sizeof(PersistentCacheHeader));
+    strcpy(magic, PERSISTENT_CACHE_MAGIC);
+    version = PERSISTENT_CACHE_VERSION;
+  }
+
+  /**
+     Compare the header of a file with the one of the current run.
+
+     @param[in] h, the header of the current run
+     \return NULL if the file can be used, the reason of the rejection otherwise
+   */
+  const char *incompatibility(PersistentCacheHeader &h)
+  {
+    if(strcmp(magic, PERSISTENT_CACHE_MAGIC)) return "not a cache file";
+    if(version != h.version || sizeInfo != h.sizeInfo) return "wrong version";
+    if(valueKind != h.valueKind) return "the counts are not of the same type";
+    if(modeStore != h.modeStore) return "the keys do not store the same part of the formula";
+    if(representation != h.representation) return "the keys are not encoded the same way";
+    if(nbVar != h.nbVar) return "the variable numbering is different";
+    if(formulaSignature != h.formulaSignature) return "the clause database is different";
+    if(weightSignature != h.weightSignature) return "the weights or the projected variables are different";
+    return NULL;
+  }// incompatibility
+};
+
+
+/**
+   Encode the counts as strings (exact for both types: the floating
+   point numbers are written in base 16).
+ */
+inline uint32_t persistentValueKind(mpz_int &v){return 1;}
+inline uint32_t persistentValueKind(mpf_float &v){return 2;}
+
+inline std::string encodePersistentValue(mpz_int &v){return v.str();}
+
+inline std::string encodePersistentValue(mpf_float &v)
+{
+  mp_exp_t e;
+  char *digits = mpf_get_str(NULL, &e, 16, 0, v.backend().data());
+  bool neg = digits[0] == '-';
+
+  std::string ret = !digits[0] ? std::string("0") :
+    std::string(neg ? "-0." : "0.") + (neg ? &digits[1] : digits) + "@" + std::to_string(e);
+  void (*freeFunc)(void *, size_t);
+  mp_get_memory_functions(NULL, NULL, &freeFunc);
+  freeFunc(digits, strlen(digits) + 1);
+  return ret;
+}// encodePersistentValue
+
+inline bool decodePersistentValue(const char *s, mpz_int &v)
+{
+  return !mpz_set_str(v.backend().data(), s, 10);
+}
+
+inline bool decodePersistentValue(const char *s, mpf_float &v)
+{
+  return !mpf_set_str(v.backend().data(), s, -16);
+}
+
+#endif
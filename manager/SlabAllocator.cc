@@ -0,0 +1,249 @@
+/*
+* d4
+* Copyright (C) 2020  Univ. Artois & CNRS
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cassert>
+#include <sys/mman.h>
+
+#include "../manager/SlabAllocator.hh"
+
+/**
+   Constructor.
+ */
+SlabAllocator::SlabAllocator()
+{
+  for(int i = 0 ; i<NB_SIZE_CLASS ; i++)
+    {
+      classes[i].partial = NULL;
+      classes[i].nbBlock = classes[i].nbRequested = classes[i].nbSlab = 0;
+    }
+
+  for(int i = 0 ; i<NB_SMALL_CLASS ; i++) classSize[i] = (i + 1) << 3;
+  for(int p = 7, i = NB_SMALL_CLASS ; i<NB_SIZE_CLASS ; p++)
+    for(int j = 1 ; j<=4 ; j++, i++) classSize[i] = (1 << p) + j * (1 << (p - 2));
+  assert(classSize[NB_SIZE_CLASS - 1] == MAX_SIZE_CLASS);
+
+  pool = NULL;
+  currentArena = NULL;
+  nextSlab = NB_SLAB_ARENA;
+  nbArena = nbHugeArena = nbSlabPool = nbSlabReleased = nbLarge = sizeLarge = 0;
+}// constructor
+
+
+/**
+   Get an empty slab: from the pool if possible, otherwise from the
+   current arena (a new arena is mapped when it is full).
+
+   \return the slab
+ */
+SlabAllocator::SlabInfo *SlabAllocator::getSlab()
+{
+  std::lock_guard<std::mutex> guard(poolLock);
+
+  if(pool)
+    {
+      SlabInfo *s = pool;
+      pool = s->next;
+      nbSlabPool--;
+      return s;
+    }
+
+  if(nextSlab == NB_SLAB_ARENA)
+    {
+      // map twice the size to get an aligned arena
+      char *m = (char *) mmap(NULL, 2 * SIZE_ARENA, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+      if(m == MAP_FAILED)
+        {
+          fprintf(stderr, "c Cannot allocate memory for the cache\n");
+          exit(30);
+        }
+
+      char *a = (char *) (((uintptr_t) m + SIZE_ARENA - 1) & ~(SIZE_ARENA - 1));
+      if(a != m) munmap(m, a - m);
+      munmap(a + SIZE_ARENA, m + SIZE_ARENA - a);
+
+      currentArena = a;
+      nextSlab = 1; // the first slab describes the others
+      nbArena++;
+
+      // the pages are only committed when they are used: the first
+      // arena keeps small pages so that a small instance stays small
+#ifdef MADV_HUGEPAGE
+      if(nbArena > 1 && !madvise(a, SIZE_ARENA, MADV_HUGEPAGE)) nbHugeArena++;
+#endif
+    }
+
+  return &((ArenaHeader *) currentArena)->slabs[nextSlab++];
+}// getSlab
+
+
+/**
+   Give an empty slab back to the pool, its pages are given back to the
+   system.
+
+   @param[in] s, the slab
+ */
+void SlabAllocator::releaseSlab(SlabInfo *s)
+{
+  madvise(slabData(s), SIZE_SLAB, MADV_DONTNEED);
+
+  std::lock_guard<std::mutex> guard(poolLock);
+  s->cls = -1;
+  s->next = pool;
+  pool = s;
+  nbSlabPool++;
+  nbSlabReleased++;
+}// releaseSlab
+
+
+inline void SlabAllocator::removePartial(SizeClass &c, SlabInfo *s)
+{
+  if(s->prev) s->prev->next = s->next; else c.partial = s->next;
+  if(s->next) s->next->prev = s->prev;
+  s->inPartial = false;
+}// removePartial
+
+
+inline void SlabAllocator::pushPartial(SizeClass &c, SlabInfo *s)
+{
+  s->prev = NULL;
+  s->next = c.partial;
+  if(c.partial) c.partial->prev = s;
+  c.partial = s;
+  s->inPartial = true;
+}// pushPartial
+
+
+/**
+   Allocate a block.
+
+   @param[in] size, the number of octets
+   \return the block
+ */
+char *SlabAllocator::allocate(unsigned size)
+{
+  if(size > MAX_SIZE_CLASS)
+    {
+      char *m = (char *) mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if(m == MAP_FAILED)
+        {
+          fprintf(stderr, "c Cannot allocate memory for the cache\n");
+          exit(30);
+        }
+
+      std::lock_guard<std::mutex> guard(poolLock);
+      nbLarge++;
+      sizeLarge += size;
+      return m;
+    }
+
+  int cls = classOf(size);
+  SizeClass &c = classes[cls];
+  std::lock_guard<std::mutex> guard(c.lock);
+
+  SlabInfo *s = c.partial;
+  if(!s)
+    {
+      s = getSlab();
+      s->freeList = NULL;
+      s->nbLive = s->nbBump = 0;
+      s->cls = cls;
+      pushPartial(c, s);
+      c.nbSlab++;
+    }
+
+  char *ret;
+  if(s->freeList)
+    {
+      ret = s->freeList;
+      memcpy(&s->freeList, ret, sizeof(char *));
+    }
+  else ret = slabData(s) + (s->nbBump++) * classSize[cls];
+
+  if(++s->nbLive == nbBlockSlab(cls)) removePartial(c, s);
+  c.nbBlock++;
+  c.nbRequested += size;
+  return ret;
+}// allocate
+
+
+/**
+   Free a block.
+
+   @param[in] p, the block
+   @param[in] size, the size given to allocate
+ */
+void SlabAllocator::release(char *p, unsigned size)
+{
+  if(size > MAX_SIZE_CLASS)
+    {
+      munmap(p, size);
+      std::lock_guard<std::mutex> guard(poolLock);
+      nbLarge--;
+      sizeLarge -= size;
+      return;
+    }
+
+  int cls = classOf(size);
+  SizeClass &c = classes[cls];
+  SlabInfo *s = slabOf(p);
+
+  std::unique_lock<std::mutex> guard(c.lock);
+  assert(s->cls == cls && s->nbLive);
+
+  memcpy(p, &s->freeList, sizeof(char *));
+  s->freeList = p;
+  c.nbBlock--;
+  c.nbRequested -= size;
+
+  if(!s->inPartial) pushPartial(c, s);
+  if(--s->nbLive) return;
+
+  // an empty slab is kept only if it is the last one of the class
+  if(c.partial == s && !s->next) return;
+  removePartial(c, s);
+  c.nbSlab--;
+  guard.unlock();
+  releaseSlab(s);
+}// release
+
+
+/**
+   Print the memory used by the blocks and the fragmentation: the
+   internal one is the part of the blocks that is not asked for, the
+   external one the part of the slabs in use that is not in a block.
+ */
+void SlabAllocator::printInformation()
+{
+  unsigned long int nbSlab = 0, nbBlockOctet = 0, nbRequested = 0;
+  for(int i = 0 ; i<NB_SIZE_CLASS ; i++)
+    {
+      nbSlab += classes[i].nbSlab;
+      nbBlockOctet += classes[i].nbBlock * classSize[i];
+      nbRequested += classes[i].nbRequested;
+    }
+
+  printf("c Memory of the keys: %.1f MB in %lu slabs (%lu arenas, %lu with huge pages), %.1f MB in %lu large blocks\n",
+         (nbSlab * SIZE_SLAB) / (double) (1<<20), nbSlab, nbArena, nbHugeArena, sizeLarge / (double) (1<<20), nbLarge);
+  printf("c Number of slabs given back to the system: %lu (%lu in the pool)\n", nbSlabReleased, nbSlabPool);
+  printf("c Fragmentation of the keys: %.1f%% internal, %.1f%% external\n",
+         nbBlockOctet ? 100.0 * (nbBlockOctet - nbRequested) / nbBlockOctet : 0,
+         nbSlab ? 100.0 * (nbSlab * SIZE_SLAB - nbBlockOctet) / (nbSlab * SIZE_SLAB) : 0);
+}// printInformation
@@ -0,0 +1,130 @@
+/*
+* d4
+* Copyright (C) 2020  Univ. Artois & CNRS
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef MANAGER_SLAB_ALLOCATOR
+#define MANAGER_SLAB_ALLOCATOR
+
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+
+#define LOG_SIZE_SLAB 16   // 64KB
+#define LOG_SIZE_ARENA 26  // 64MB
+#define SIZE_SLAB (1UL << LOG_SIZE_SLAB)
+#define SIZE_ARENA (1UL << LOG_SIZE_ARENA)
+#define NB_SLAB_ARENA (1 << (LOG_SIZE_ARENA - LOG_SIZE_SLAB))
+
+#define NB_SMALL_CLASS 16  // 8, 16, ..., 128 octets
+#define NB_SIZE_CLASS 44   // then 4 classes per power of two up to MAX_SIZE_CLASS
+#define MAX_SIZE_CLASS 16384
+
+
+/**
+   Memory of the cache keys (see BucketManagerInterface::getArray).
+
+   The blocks are grouped by size class, each class takes its blocks in
+   slabs of 64KB cut in blocks of the same size. A slab that becomes
+   empty goes back to a pool common to all the classes (its pages are
+   given back to the system with madvise), then the memory freed by a
+   class can be used by the other ones. The slabs are taken from arenas
+   of 64MB aligned on their size: the description of the slabs is at the
+   beginning of the arena, which gives the slab of a block from its
+   address. An arena only reserves address space, its pages are
+   committed when they are used (with huge pages from the second arena
+   when the system provides them). The blocks bigger than MAX_SIZE_CLASS are directly mapped.
+
+   The allocator is shared by all the bucket managers: an entry of a
+   shared cache can be freed by another worker than the one that
+   allocated it. Each class has its own lock.
+ */
+class SlabAllocator
+{
+  struct SlabInfo
+  {
+    char *freeList;          // the freed blocks (the next one is stored in the block)
+    unsigned nbLive, nbBump; // nbBump first blocks have been used at least once
+    int cls;                 // -1 when the slab is in the pool
+    SlabInfo *prev, *next;   // list of the slabs of the class with free blocks, or pool
+    bool inPartial;
+  };
+
+  struct ArenaHeader
+  {
+    SlabInfo slabs[NB_SLAB_ARENA];
+  };
+  static_assert(sizeof(ArenaHeader) <= SIZE_SLAB, "the description of the slabs must fit in the first slab");
+
+  struct SizeClass
+  {
+    std::mutex lock;
+    SlabInfo *partial;
+    unsigned long int nbBlock, nbRequested, nbSlab; // live blocks, octets asked for them, slabs
+  };
+
+  SizeClass classes[NB_SIZE_CLASS];
+  unsigned classSize[NB_SIZE_CLASS];
+
+  std::mutex poolLock;
+  SlabInfo *pool;
+  char *currentArena;
+  unsigned nextSlab;
+
+  // statistics (under poolLock)
+  unsigned long int nbArena, nbHugeArena, nbSlabPool, nbSlabReleased, nbLarge, sizeLarge;
+
+  static inline char *slabData(SlabInfo *s)
+  {
+    ArenaHeader *a = (ArenaHeader *) ((uintptr_t) s & ~(SIZE_ARENA - 1));
+    return (char *) a + ((s - a->slabs) << LOG_SIZE_SLAB);
+  }
+
+  static inline SlabInfo *slabOf(char *p)
+  {
+    ArenaHeader *a = (ArenaHeader *) ((uintptr_t) p & ~(SIZE_ARENA - 1));
+    return &a->slabs[((uintptr_t) p & (SIZE_ARENA - 1)) >> LOG_SIZE_SLAB];
+  }
+
+  static inline int classOf(unsigned size)
+  {
+    if(size <= 8 * NB_SMALL_CLASS) return size ? (size - 1) >> 3 : 0;
+    int p = 31 - __builtin_clz(size - 1);
+    return NB_SMALL_CLASS + ((p - 7) << 2) + ((size - 1 - (1 << p)) >> (p - 2));
+  }
+
+  inline unsigned nbBlockSlab(int cls){return SIZE_SLAB / classSize[cls];}
+
+  SlabInfo *getSlab();
+  void releaseSlab(SlabInfo *s);
+  inline void removePartial(SizeClass &c, SlabInfo *s);
+  inline void pushPartial(SizeClass &c, SlabInfo *s);
+
+public:
+  SlabAllocator();
+
+  char *allocate(unsigned size);
+  void release(char *p, unsigned size);
+
+  void printInformation();
+
+  static SlabAllocator &global()
+  {
+    static SlabAllocator allocator;
+    return allocator;
+  }
+};
+
+#endif
@@ -32,6 +32,7 @@ using namespace std;
 DynamicOccurrenceManager::DynamicOccurrenceManager(int nbC, int nbV, int maxClSz) :
     CnfOccurrenceManager(nbC, nbV, maxClSz)
 {
+  initOccurrences();
 }// DynamicOccurrenceManager
 
 /**
@@ -44,40 +45,33 @@ DynamicOccurrenceManager::DynamicOccurrenceManager(int nbC, int nbV, int maxClSz
 DynamicOccurrenceManager::DynamicOccurrenceManager(vec<vec<Lit> > &_clauses, int _nbVar) :
     CnfOccurrenceManager(_clauses, _nbVar)
 {
-  for(int i = 0 ; i<clauses.size() ; i++)
-    {
-      vec<Lit> &c = clauses[i];
-      for(int j = 0 ; j<c.size() ; j++) occList[toInt(c[j])].push(i);
-    }
+  initOccurrences();
 }// DynamicOccurrenceManager
 
 
 /**
-   Initiliaze the occurrence manager with a new set of clauses.
+   Construct the occurrence lists and the position of each occurrence.
  */
-void DynamicOccurrenceManager::initFormula(vec<vec<Lit> > &_clauses)
+void DynamicOccurrenceManager::initOccurrences()
 {
-  CnfOccurrenceManager::initFormula(_clauses);
+  occPos.clear();
+  occPos.growTo(lits.size());
+  occSlot.clear();
+  occSlot.growTo(lits.size());
 
-  // clear the occurrence list
-  for(int i = 0 ; i<occList.size() ; i++) occList[i].clear();
+  for(int i = 0 ; i<occSize.size() ; i++) occSize[i] = binSize[i] = 0;
+  for(int i = 0 ; i<getNbClause() ; i++)
+    for(int j = 0 ; j<getSizeClause(i) ; j++) attachOccurrence(i, j);
+}// initOccurrences
 
-  // construct the occurrence list
-  for(int i = 0 ; i<clauses.size() ; i++)
-    {
-      vec<Lit> &c = clauses[i];
-      for(int j = 0 ; j<c.size() ; j++) occList[toInt(c[j])].push(i);
-      if(c.size() > maxSizeClause) maxSizeClause = c.size();
-    }
 
-  mustUnMark.capacity(clauses.size());
-  for(int i = 0 ; i<clauses.size() ; i++)
-  {
-    if(markView.size() > i) markView[i] = false; else markView.push(false);
-    if(nbUnsat.size() > i) nbUnsat[i] = 0; else nbUnsat.push(0);
-    if(nbSat.size() > i) nbSat[i] = 0; else nbSat.push(0);
-    if(watcher.size() > i) watcher[i] = clauses[i][0]; else watcher.push(clauses[i][0]);
-  }
+/**
+   Initiliaze the occurrence manager with a new set of clauses.
+ */
+void DynamicOccurrenceManager::initFormula(vec<vec<Lit> > &_clauses)
+{
+  CnfOccurrenceManager::initFormula(_clauses);
+  initOccurrences();
 }// initFormula
 
 /**
@@ -96,37 +90,47 @@ void DynamicOccurrenceManager::preUpdate(vec<Lit> &lits)
       Lit l = lits[i];
       currentValue[var(l)] = sign(l) ? l_False : l_True;
 
-      vec<int> &op = occList[toInt(l)];
-      for(int j = 0 ; j<op.size() ; j++)
+      uint64_t z = HashCnf::zobristLit(toInt(~l));
+      for(int b = 0 ; b<2 ; b++)
         {
-          int idxCl = op[j];
-          vec<Lit> &c = clauses[idxCl];
-          nbSat[idxCl]++;
-          for(int k = 0 ; k<c.size() ; k++)
-            if(currentValue[var(c[k])] == l_Undef)
-              removeIdxFromOccList(occList[toInt(c[k])], occList[toInt(l)][j]);
-        }
+          VecView<int> op = b ? getVecIdxBinaryClause(l) : getVecIdxClause(l);
+          for(int j = 0 ; j<op.size() ; j++)
+            {
+              int idxCl = op[j];
+              VecView<Lit> c = getClause(idxCl);
+              ClauseInfo &ci = clauseInfo[idxCl];
+              ci.nbSat++;
+              if(c.size() - ci.nbUnsat == 2) updateResidualBinary(idxCl, -1);
+              for(int k = 0 ; k<c.size() ; k++)
+                if(currentValue[var(c[k])] == l_Undef) detachOccurrence(idxCl, k);
+            }
 
-      vec<int> &on = occList[toInt(~l)];
-      for(int j = 0 ; j<on.size() ; j++)
-      {
-        int idxCl = on[j];
-        nbUnsat[idxCl]++;
-        if(watcher[idxCl] == ~l) reviewWatcher.push(idxCl);
-      }
+          VecView<int> on = b ? getVecIdxBinaryClause(~l) : getVecIdxClause(~l);
+          for(int j = 0 ; j<on.size() ; j++)
+            {
+              ClauseInfo &ci = clauseInfo[on[j]];
+              ci.nbUnsat++;
+              ci.residualHash ^= z;
+              if(ci.watcher == ~l) reviewWatcher.push(on[j]);
+
+              int nbFree = getSizeClause(on[j]) - ci.nbUnsat;
+              if(nbFree == 2) updateResidualBinary(on[j], 1);
+              else if(nbFree == 1) updateResidualBinary(on[j], -1);
+            }
+        }
     }
 
   // we search another non assigned literal if requiered
   for(int i = 0 ; i<reviewWatcher.size() ; i++)
   {
     int idxCl = reviewWatcher[i];
-    if(nbSat[idxCl]) continue;
+    if(clauseInfo[idxCl].nbSat) continue;
 
-    vec<Lit> &c = clauses[idxCl];
+    VecView<Lit> c = getClause(idxCl);
     for(int k = 0 ; k<c.size() ; k++)
       if(currentValue[var(c[k])] == l_Undef)
       {
-        watcher[idxCl] = c[k];
+        clauseInfo[idxCl].watcher = c[k];
         break;
       }
   }
@@ -135,7 +139,7 @@ void DynamicOccurrenceManager::preUpdate(vec<Lit> &lits)
   int i = 0;
   while(i<currentSize)
   {
-    if(!nbSat[currentIdx[i]]) i++;
+    if(!clauseInfo[currentIdx[i]].nbSat) i++;
     else
     {
       currentSize--;
@@ -160,24 +164,34 @@ void DynamicOccurrenceManager::postUpdate(vec<Lit> &lits)
     {
       Lit l = lits[i];
 
-      vec<int> &o = occList[toInt(l)];
-      for(int j = 0 ; j<o.size() ; j++)
+      uint64_t z = HashCnf::zobristLit(toInt(~l));
+      for(int b = 0 ; b<2 ; b++)
         {
-          int idxCl = o[j];
-          vec<Lit> &c = clauses[idxCl];
-          nbSat[idxCl]--;
+          VecView<int> o = b ? getVecIdxBinaryClause(l) : getVecIdxClause(l);
+          for(int j = 0 ; j<o.size() ; j++)
+            {
+              int idxCl = o[j];
+              VecView<Lit> c = getClause(idxCl);
+              ClauseInfo &ci = clauseInfo[idxCl];
+              ci.nbSat--;
+
+              for(int k = 0 ; k<c.size() ; k++)
+                if(currentValue[var(c[k])] == l_Undef) attachOccurrence(idxCl, k);
+              if(c.size() - ci.nbUnsat == 2) updateResidualBinary(idxCl, 1);
+            }
 
-          for(int k = 0 ; k<c.size() ; k++)
+          VecView<int> on = b ? getVecIdxBinaryClause(~l) : getVecIdxClause(~l);
+          for(int j = 0 ; j<on.size() ; j++)
             {
-              if(currentValue[var(c[k])] == l_Undef)
-                {
-                  assert(occList[toInt(c[k])].size() < occList[toInt(c[k])].capacity());
-                  occList[toInt(c[k])].push_(occList[toInt(l)][j]);
-                }
+              ClauseInfo &ci = clauseInfo[on[j]];
+              int nbFree = getSizeClause(on[j]) - ci.nbUnsat;
+              if(nbFree == 2) updateResidualBinary(on[j], -1);
+              else if(nbFree == 1) updateResidualBinary(on[j], 1);
+
+              ci.nbUnsat--;
+              ci.residualHash ^= z;
             }
         }
-
-      for(int j = 0 ; j<occList[toInt(~l)].size() ; j++) nbUnsat[occList[toInt(~l)][j]]--;
       currentValue[var(l)] = l_Undef;
     }
 
@@ -185,26 +199,6 @@ void DynamicOccurrenceManager::postUpdate(vec<Lit> &lits)
 }// unassignValue
 
 
-/**
-   Remove a value from a vector.
- */
-void DynamicOccurrenceManager::removeIdxFromOccList(vec<int> &o, int idx)
-{
-  assert(o.size());
-
-  for(int i = 0 ; i<o.size() ; i++)
-    {
-      if(o[i] == idx)
-        {
-          o[i] = o.last();
-          o.pop();
-          return;
-        }
-    }
-  assert(0);
-}// removeIdxFromOccList
-
-
 /////////////////////////////////////////////////////////////////////////////////
 ///////////////////////////      DEBUGGING FUNCTION      ////////////////////////
 /////////////////////////////////////////////////////////////////////////////////
@@ -216,24 +210,24 @@ void DynamicOccurrenceManager::debug(Solver &s)
 {
   cerr << "We call the DynamicOccurrenceManager debugging function" << endl;
 
-  for(int i = 0 ; i<clauses.size() ; i++)
+  for(int i = 0 ; i<getNbClause() ; i++)
     {
       int nbU = 0;
       bool isSAT = false;
 
-      vec<Lit> &c = clauses[i];
+      VecView<Lit> c = getClause(i);
       for(int j = 0 ; !isSAT && j<c.size() ; j++)
         if(s.value(c[j]) == l_True) isSAT = true;
         else if(s.value(c[j]) == l_False) nbU++;
 
       if(!isSAT)
         {
-          assert(nbUnsat[i] == nbU);
+          assert(clauseInfo[i].nbUnsat == nbU);
 
           for(int j = 0 ; j<c.size() ; j++)
             if(s.value(c[j]) == l_Undef)
               {
-                vec<int> &occ = occList[toInt(c[j])];
+                VecView<int> occ = clauseInfo[i].binary ? getVecIdxBinaryClause(c[j]) : getVecIdxClause(c[j]);
                 int isIn = false;
                 for(int k = 0 ; k<occ.size() && !isIn ; k++) isIn = occ[k] == i;
                 assert(isIn);
@@ -241,24 +235,34 @@ void DynamicOccurrenceManager::debug(Solver &s)
         }
     }
 
-  for(int i = 0 ; i<occList.size() ; i++)
+  for(int i = 0 ; i<occSize.size() ; i++)
     {
-      // verify that we do not have twice the same index in the occurrence list.
-      for(int j = 0 ; j<occList[i].size() ; j++)
-        for(int k = j + 1 ; k<occList[i].size() ; k++)
-          assert(occList[i][j] != occList[i][k]);
-
-      // verify that no clause are satisfied
       Lit l = mkLit(i>>1, i&1);
+      int nbResidual = 0;
 
-      if(s.value(l) != l_Undef) continue;
-      for(int j = 0 ; j<occList[i].size() ; j++)
+      for(int b = 0 ; b<2 ; b++)
         {
-          bool isSAT = false;
-          for(int k = 0 ; k<clauses[occList[i][j]].size() && isSAT ; k++)
-            isSAT = s.value(clauses[occList[i][j]][k]) == l_True;
+          VecView<int> occ = b ? getVecIdxBinaryClause(l) : getVecIdxClause(l);
 
-          assert(!isSAT);
+          // verify that we do not have twice the same index in the occurrence list.
+          for(int j = 0 ; j<occ.size() ; j++)
+            for(int k = j + 1 ; k<occ.size() ; k++)
+              assert(occ[j] != occ[k]);
+
+          // verify that no clause are satisfied
+          if(litIsAssigned(l)) continue;
+          for(int j = 0 ; j<occ.size() ; j++)
+            {
+              bool isSAT = false;
+              VecView<Lit> c = getClause(occ[j]);
+              for(int k = 0 ; k<c.size() && !isSAT ; k++)
+                isSAT = litIsAssignedToTrue(c[k]);
+
+              assert(!isSAT);
+              if(c.size() - clauseInfo[occ[j]].nbUnsat == 2) nbResidual++;
+            }
         }
+
+      assert(litIsAssigned(l) || nbResidual == nbResidualBinary[i]);
     }
 }// debug
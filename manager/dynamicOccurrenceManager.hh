@@ -29,10 +29,57 @@
 
 #include "../manager/CnfOccurrenceManager.hh"
 
+/**
+   The occurrence lists (binary or not) only contain the clauses that
+   are not satisfied. Each occurrence of a literal in a clause has a slot
+   (clauseStart[idx] + position of the literal in the clause) which
+   gives its position in the occurrence list of the literal (occPos),
+   and occSlot (parallel to occIdx) gives the slot of each element of
+   the occurrence lists: a clause is removed from the occurrence list
+   of a literal in constant time, by moving the last element of the
+   list at its place.
+ */
 class DynamicOccurrenceManager : public CnfOccurrenceManager
 {
 private:
+  vec<int> occPos, occSlot;
+
   void initClauses(vec<vec<Lit> > &clauses);
+  void initOccurrences();
+
+  /**
+     Remove the clause idx from the occurrence list of its kth literal.
+   */
+  inline void detachOccurrence(int idx, int k)
+  {
+    int slot = clauseStart[idx] + k, l = toInt(lits[slot]);
+    bool binary = clauseInfo[idx].binary;
+    int first = binary ? binStart[l] : occStart[l], pos = occPos[slot];
+    int last = first + (binary ? --binSize[l] : --occSize[l]);
+    assert(occIdx[first + pos] == idx);
+
+    occIdx[first + pos] = occIdx[last];
+    occSlot[first + pos] = occSlot[last];
+    if(binary) binOther[first + pos] = binOther[last];
+    occPos[occSlot[first + pos]] = pos;
+  }// detachOccurrence
+
+  /**
+     Put back the clause idx at the end of the occurrence list of its
+     kth literal.
+   */
+  inline void attachOccurrence(int idx, int k)
+  {
+    int slot = clauseStart[idx] + k, l = toInt(lits[slot]);
+    bool binary = clauseInfo[idx].binary;
+    int pos = binary ? binSize[l]++ : occSize[l]++, first = binary ? binStart[l] : occStart[l];
+    assert(first + pos < (binary ? occStart[l + 1] : binStart[l]));
+
+    occPos[slot] = pos;
+    occIdx[first + pos] = idx;
+    occSlot[first + pos] = slot;
+    if(binary) binOther[first + pos] = lits[clauseStart[idx] + 1 - k];
+  }// attachOccurrence
 
 public:
   DynamicOccurrenceManager(int nbClause, int nbVar, int maxClauseSize);
@@ -41,7 +88,6 @@ public:
   void preUpdate(vec<Lit> &lits);
   void postUpdate(vec<Lit> &lits);
   void debug(Solver &s);
-  void removeIdxFromOccList(vec<int> &o, int idx);
 
   // we cannot use this function here
   inline void initialize(vec<Var> &setOfVar, vec<Lit> &units){assert(0);}
@@ -28,10 +28,11 @@ GreedyOccurrenceManager::GreedyOccurrenceManager(vec<vec<Lit> > &_clauses, int _
   for(int i = 0 ; i<(nbVar<<1) ; i++) initOccList.push();
   
   counterStampViewClause = 0;
-  for(int i = 0 ; i<clauses.size() ; i++)
+  for(int i = 0 ; i<getNbClause() ; i++)
     {
-      for(int j = 0 ; j<clauses[i].size() ; j++)
-        initOccList[toInt(clauses[i][j])].push(i);
+      VecView<Lit> c = getClause(i);
+      for(int j = 0 ; j<c.size() ; j++)
+        initOccList[toInt(c[j])].push(i);
 
       stampViewClause.push(0);
     }
@@ -40,8 +41,8 @@ GreedyOccurrenceManager::GreedyOccurrenceManager(vec<vec<Lit> > &_clauses, int _
 
 /**
    Visit the set of not already visided clauses where the literal l
-   occur and initialize the data structures nbSat, nbUnsat and the
-   occList w.r.t. the currentValue table.
+   occur and initialize the data structures nbUnsat, nbResidualBinary
+   and the occurrence lists w.r.t. the currentValue table.
 
    @param[in] l, a literal
  */
@@ -53,23 +54,30 @@ void GreedyOccurrenceManager::initializeFromLiteral(Lit l)
     if(stampViewClause[occ[j]] != counterStampViewClause)
       {
         stampViewClause[occ[j]] = counterStampViewClause;
-        nbUnsat[occ[j]] = 0;
+        ClauseInfo &ci = clauseInfo[occ[j]];
+        ci.nbUnsat = 0;
 
-        assert(occ[j] < clauses.size());        
-        vec<Lit> &cl = clauses[occ[j]];
+        assert(occ[j] < getNbClause());
+        VecView<Lit> cl = getClause(occ[j]);
         bool isSAT = false;
         for(int k = 0 ; k<cl.size() && !isSAT ; k++)
           {
             if(currentValue[var(cl[k])] != l_Undef)
               {
                 isSAT = (sign(cl[k]) && currentValue[var(cl[k])] == l_False) || (!sign(cl[k]) && currentValue[var(cl[k])] == l_True);
-                if(!isSAT) nbUnsat[occ[j]]++;
+                if(!isSAT) ci.nbUnsat++;
               }
           }
 
         if(isSAT) continue;
+        ci.residualHash = 0;
         for(int k = 0 ; k<cl.size() ; k++)
-          if(currentValue[var(cl[k])] == l_Undef) occList[toInt(cl[k])].push(occ[j]);
+          if(currentValue[var(cl[k])] == l_Undef)
+            {
+              pushOccurrence(cl[k], occ[j]);
+              ci.residualHash ^= HashCnf::zobristLit(toInt(cl[k]));
+            }
+        if(cl.size() - ci.nbUnsat == 2) updateResidualBinary(occ[j], 1);
       }
 }// initializeFromLiteral
 
@@ -90,8 +98,9 @@ void GreedyOccurrenceManager::initialize(vec<Var> &setOfVar, vec<Lit> &units)
   for(int i = 0 ; i<setOfVar.size() ; i++)
     {
       Lit l = mkLit(setOfVar[i], false);
-      occList[toInt(l)].clear();
-      occList[toInt(~l)].clear();
+      clearOccurrence(l);
+      clearOccurrence(~l);
+      nbResidualBinary[toInt(l)] = nbResidualBinary[toInt(~l)] = 0;
     }
   
   for(int i = 0 ; i<setOfVar.size() ; i++)
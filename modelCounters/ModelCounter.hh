@@ -40,6 +40,7 @@
 #include "../utils/Dimacs.hh"
 #include "../utils/Solver.hh"
 #include "../utils/equiv.hh"
+#include "../utils/ContextPool.hh"
 
 #include "../mtl/Sort.hh"
 #include "../mtl/Vec.hh"
@@ -52,6 +53,7 @@
 #define NB_SEP_MC 129
 #define MASK_SHOWRUN_MC ((2<<13) - 1)
 
+#include <vector>
 #include <boost/multiprecision/gmp.hpp>
 using namespace boost::multiprecision;
 
@@ -71,12 +73,14 @@ private:
 
   unsigned int nbDecisionNode;
   CacheCNF<T> *cache;
+  bool ownCache;
 
   vec<unsigned> stampVar;
   unsigned stampIdx;
 
   int freqLimitDyn;
   int optCached;
+  bool verb;
   bool optDomConst;
   bool optReversePolarity;
 
@@ -93,6 +97,14 @@ private:
 
   int limitCacheDyn;
   TmpEntry<T> NULL_CACHE_ENTRY;
+  const char *cacheStore;
+  const char *cacheRepresentation;
+
+  // parallel evaluation of the independent components
+  ContextPool<ModelCounter<T> > *pool;
+  bool ownPool;
+  int minVarParallel;
+  int nbParallelComponent;
 
   /**
      Compute the current priority set.
@@ -137,7 +149,8 @@ private:
     if(nbComponent)
       {
         nbSplit += (nbComponent > 1) ? nbComponent : 0;
-        for(int cp = 0 ; cp<nbComponent ; cp++)
+        if(pool && nbComponent > 1) ret = computeParallelComponents(varConnected, priorityVar);
+        else for(int cp = 0 ; cp<nbComponent ; cp++)
           {
             vec<Var> &connected = varConnected[cp];
             bool localCache = optCached;
@@ -153,7 +166,7 @@ private:
               computePrioritySubSet(connected, priorityVar, currPriority);
               ret *= (curr = computeDecisionNode(connected, currPriority));
 
-              if(localCache) cache->addInCache(cb, curr);
+              if(localCache) cache->addInCache(cb, curr, bm, connected);
             }
             occManager->popPreviousClauseSet();
           }
@@ -163,6 +176,106 @@ private:
     return ret;
   }// computeNbModel_
 
+
+  /**
+     Compute the product of the number of models of independent
+     components. The components that are not in the cache and that
+     are large enough are given to the idle contexts of the pool, the
+     other ones are computed by the current thread. The cache of this
+     counter is searched and filled as in the sequential case.
+
+     @param[in] varConnected, the components
+     @param[in] priorityVar, select in priority these variable to the next decision node
+     \return the product of the number of models of the components
+  */
+  T computeParallelComponents(vec< vec<Var> > &varConnected, vec<Var> &priorityVar)
+  {
+    int nbComponent = varConnected.size();
+    std::vector<TmpEntry<T> > entries(nbComponent);
+    std::vector<T> values(nbComponent);
+    vec< vec<Var> > currPriority(nbComponent);
+    vec<int> launched(nbComponent, -1);
+    vec<Lit> context;
+    bool contextBuilt = false;
+
+    // search in the cache and give away the large components
+    for(int cp = 0 ; cp<nbComponent ; cp++)
+      {
+        vec<Var> &connected = varConnected[cp];
+
+        occManager->updateCurrentClauseSet(connected);
+        entries[cp] = optCached ? cache->searchInCache(connected, bm) : NULL_CACHE_ENTRY;
+        occManager->popPreviousClauseSet();
+
+        if(entries[cp].defined){ values[cp] = entries[cp].getValue(); continue; }
+        computePrioritySubSet(connected, priorityVar, currPriority[cp]);
+        if(connected.size() < minVarParallel) continue;
+
+        if(!contextBuilt)
+          {
+            for(int i = 0 ; i<s.nVars() ; i++)
+              if(s.value(i) != l_Undef) context.push(mkLit(i, s.value(i) == l_False));
+            contextBuilt = true;
+          }
+
+        vec<Var> &prio = currPriority[cp];
+        T &val = values[cp];
+        launched[cp] = pool->tryLaunch([&context, &connected, &prio, &val](ModelCounter<T> *mc)
+                                       { val = mc->computeDetachedComponent(context, connected, prio); });
+      }
+
+    // the remaining components are computed here
+    for(int cp = 0 ; cp<nbComponent ; cp++)
+      {
+        if(entries[cp].defined || launched[cp] >= 0) continue;
+
+        occManager->updateCurrentClauseSet(varConnected[cp]);
+        values[cp] = computeComponent(varConnected[cp], currPriority[cp]);
+        occManager->popPreviousClauseSet();
+      }
+
+    T ret = 1;
+    for(int cp = 0 ; cp<nbComponent ; cp++)
+      {
+        if(launched[cp] >= 0)
+          {
+            pool->wait(launched[cp]);
+            nbParallelComponent++;
+          }
+
+        if(optCached && !entries[cp].defined)
+          {
+            occManager->updateCurrentClauseSet(varConnected[cp]);
+            cache->addInCache(entries[cp], values[cp], bm, varConnected[cp]);
+            occManager->popPreviousClauseSet();
+          }
+        ret *= values[cp];
+      }
+
+    return ret;
+  }// computeParallelComponents
+
+
+  /**
+     Compute the number of models of a component at the current
+     level. The clauses learnt since the component was built can
+     have assigned some of its variables, or all of them: the solver
+     is called again and these literals are weighted as the unit
+     literals of a regular call.
+
+     @param[in] component, the variables of the component
+     @param[in] priorityVar, select in priority these variable to the next decision node
+     \return the number of models of the component
+  */
+  T computeComponent(vec<Var> &component, vec<Var> &priorityVar)
+  {
+    vec<Lit> unitsLit;
+    vec<Var> freeVariable;
+
+    T ret = computeNbModel_(component, unitsLit, freeVariable, priorityVar);
+    return ret * computeWeightUnitFree(unitsLit, freeVariable);
+  }// computeComponent
+
   /**
      This function select a variable and compile a decision node.
 
@@ -171,11 +284,9 @@ private:
   */
   T computeDecisionNode(vec<Var> &connected, vec<Var> &priorityVar)
   {
-    if(pv && !priorityVar.size() && connected.size() > 10 && connected.size() < 5000)
+    if(pv && !priorityVar.size() && pv->isUsedOn(connected.size()))
       {
-        vec<int> cutSet;
-        pv->computePartition(connected, cutSet, priorityVar, vs->getScoringFunction());
-        callPartitioner++;
+        if(!pv->computeCut(connected, priorityVar, vs->getScoringFunction())) callPartitioner++;
       }
 
     Var v = var_Undef;
@@ -227,6 +338,7 @@ private:
 
   inline void showRun()
   {
+    if(!verb) return;
     if(!(nbCallCall & (MASK_HEADER))) showHeader();
     if(nbCallCall && !(nbCallCall & MASK_SHOWRUN_MC)) showInter();
   }
@@ -235,8 +347,9 @@ private:
 
 
   inline void init(int nbClauses, int maxSizeClause, vec<double> &wl, OptionManager &optList,
-                   vec<bool> &isProjectedVar)
+                   vec<bool> &isProjectedVar, bool _verb, CacheCNF<T> *sharedCache = NULL)
   {
+    verb = _verb;
     wl.copyTo(weightLit);
     for(int i = 0 ; i<wl.size()>>1 ; i++) s.newVar();
     for(int i = 0 ; i<s.nVars() ; i++)
@@ -245,24 +358,39 @@ private:
     }
     limitCacheDyn = s.nVars();
 
+    pool = NULL;
+    ownPool = false;
+    minVarParallel = optList.minVarParallel;
+    nbParallelComponent = 0;
+
     callPartitioner = callEquiv = 0;
     optCached = optList.optCache;
     optReversePolarity = optList.reversePolarity;
+    cacheStore = optList.cacheStore;
+    cacheRepresentation = optList.cacheRepresentation;
 
-    optList.printOptions();
+    if(verb) optList.printOptions();
 
     // initialized the data structure
     prepareVecClauses(clauses, s);
     occManager = new DynamicOccurrenceManager(0, s.nVars(), 0);
 
-    cache = new CacheCNF<T>(optList.reduceCache, optList.strategyRedCache);
-    cache->initHashTable(occManager->getNbVariable(), nbClauses, maxSizeClause);
+    ownCache = !sharedCache;
+    if(sharedCache) cache = sharedCache;
+    else
+    {
+      cache = new CacheCNF<T>(optList.reduceCache, optList.strategyRedCache);
+      cache->initHashTable(occManager->getNbVariable(), nbClauses, maxSizeClause);
+      cache->setMemoryBudget(optList.cacheMemory);
+      cache->setAdmissionPolicy(optList.cacheAdmission, optList.cacheMinVar, optList.cacheMaxVar);
+    }
 
     vs = new VariableHeuristicInterface(s, occManager, optList.varHeuristic,
                                         optList.phaseHeuristic, isProjectedVar);
     bm = new BucketManager<T>(occManager, nbClauses, s.nVars(), maxSizeClause, optList.strategyRedCache);
     pv = PartitionerInterface::getPartitioner(s, occManager, optList);
-    bm->setFixeFormula(optList.cacheStore);
+    bm->setFixeFormula(optList.cacheStore, verb);
+    bm->setRepresentation(optList.cacheRepresentation);
 
     // statistics initialization
     nbSplit = nbCallCall = 0;
@@ -277,6 +405,9 @@ private:
 public:
 
   T getWeightVar(Var v){return T(weightVar[v]);}
+  inline int getNbCall(){return nbCallCall;}
+  inline unsigned int getNbDecisionNode(){return nbDecisionNode;}
+  inline CacheCNF<T> *getCache(){return cache;}
 
   /**
      Compute the value for free and unit variables.
@@ -307,6 +438,10 @@ public:
     printf("c Number of split formula: %d\n", nbSplit);
     printf("c Number of decision: %u\n", nbDecisionNode);
     printf("c Number of paritioner calls: %u\n", callPartitioner);
+    if(pv) pv->printStatistics();
+    printf("c Number of occurrences visited to find the components: %lu (%lu avoided)\n",
+           occManager->getNbComponentVisit(), occManager->getNbAvoidedComponentVisit());
+    if(pool) printf("c Number of components computed by another context: %d\n", nbParallelComponent);
     printf("c \n");
     cache->printCacheInformation();
     printf("c Final time: %lf\n", cpuTime());
@@ -321,11 +456,12 @@ public:
      @param[in] fWeights, the vector of literal's weight
      @param[in] optList, the options
      @param[in] isProjectedVar, boolean vector used to decide if a variable is projected (true) or not (false)
+     @param[in] _verb, print the options and the progression of the search
   */
   ModelCounter(int nbClauses, int maxSizeClause, vec<double> &wl, OptionManager &optList,
-               vec<bool> &isProjectedVar)
+               vec<bool> &isProjectedVar, bool _verb = true)
   {
-    init(nbClauses, maxSizeClause, wl, optList, isProjectedVar);
+    init(nbClauses, maxSizeClause, wl, optList, isProjectedVar, _verb);
   } // ModelCounter
 
 
@@ -336,13 +472,15 @@ public:
      @param[in] fWeights, the vector of literal's weight
      @param[in] optList, the options
      @param[in] isProjectedVar, boolean vector used to decide if a variable is projected (true) or not (false)
+     @param[in] _verb, print the options and the progression of the search
   */
-  ModelCounter(vec<vec<Lit> > &cnf, vec<double> &wl, OptionManager &optList, vec<bool> &isProjectedVar)
+  ModelCounter(vec<vec<Lit> > &cnf, vec<double> &wl, OptionManager &optList, vec<bool> &isProjectedVar,
+               bool _verb = true)
   {
     // init the model counter's date structures
     int maxSizeClause = 0;
     for(int i = 0 ; i<cnf.size() ; i++) if(cnf[i].size() > maxSizeClause) maxSizeClause = cnf[i].size();
-    init(cnf.size(), maxSizeClause, wl, optList, isProjectedVar);
+    init(cnf.size(), maxSizeClause, wl, optList, isProjectedVar, _verb);
 
     // init the solver
     for(int i = 0 ; i<cnf.size() ; i++) s.addClause_(cnf[i]);
@@ -377,13 +515,141 @@ public:
     cache->setInfoFormula(s.nVars(), reduceCnf.size(), occManager->getMaxSizeClause());
   }// ModelCounter
 
+
+  /**
+     Constructor of a model counter that works on the same formula as
+     ref and shares its cache. The clauses of the occurrence manager
+     are exactly the ones of ref (same order), which is required for
+     the cache entries computed by one counter to be understood by the
+     other one. This counter does not print anything.
+
+     @param[in] ref, the model counter we share the cache with
+     @param[in] wl, the vector of literal's weight
+     @param[in] optList, the options
+     @param[in] isProjectedVar, boolean vector used to decide if a variable is projected (true) or not (false)
+   */
+  ModelCounter(ModelCounter<T> &ref, vec<double> &wl, OptionManager &optList, vec<bool> &isProjectedVar)
+  {
+    vec<vec<Lit> > refClauses;
+    for(int i = 0 ; i<ref.occManager->getNbClause() ; i++)
+    {
+      refClauses.push();
+      ref.occManager->getClause(i).copyTo(refClauses.last());
+    }
+    init(refClauses.size(), ref.occManager->getMaxSizeClause(), wl, optList, isProjectedVar, false, ref.cache);
+
+    // the solver gets the simplified formula and the units of ref
+    vec<Lit> unit;
+    for(int i = 0 ; i<ref.s.nVars() ; i++)
+      if(ref.s.value(i) != l_Undef)
+      {
+        unit.clear();
+        unit.push(mkLit(i, ref.s.value(i) == l_False));
+        s.addClause_(unit);
+      }
+
+    for(int i = 0 ; i<refClauses.size() ; i++)
+    {
+      vec<Lit> cpy;
+      refClauses[i].copyTo(cpy);
+      s.addClause_(cpy);
+    }
+
+    if(!s.solveWithAssumptions()){printf("c The formula is unsatisfiable\ns 0\n"); exit(0);}
+    s.simplify();
+    s.remove_satisfied = false;
+    s.setNeedModel(false);
+
+    freqLimitDyn = optList.freqLimitDyn;
+    occManager->initFormula(refClauses);
+    if(pv) pv->shareWith(ref.pv);
+  }// ModelCounter
+
   ~ModelCounter()
   {
+    if(ownPool) delete pool;
     if(pv) delete pv;
-    delete cache; delete vs; delete bm;
+    if(ownCache) delete cache;
+    delete vs; delete bm;
     delete occManager;
   }
 
+  /**
+     Describe the current run for the cache files: the keys built with
+     NB or NT depend on the clause database, the values on the weights
+     and on the projected variables.
+
+     @param[out] info, the header
+   */
+  void persistentCacheHeader(PersistentCacheHeader &info)
+  {
+    HashCnf hashMethod;
+    T tmp;
+
+    info.sizeInfo = sizeof(DataInfo);
+    info.valueKind = persistentValueKind(tmp);
+    info.modeStore = !strcmp(cacheStore, "ALL") ? ALL : (!strcmp(cacheStore, "NB") ? NB : NT);
+    info.representation = !strcmp(cacheRepresentation, "CP") ? REPR_CP : REPR_CL;
+    info.nbVar = s.nVars();
+
+    info.formulaSignature = 0;
+    if(info.modeStore != ALL)
+    {
+      vec<int> cnf;
+      for(int i = 0 ; i<occManager->getNbClause() ; i++)
+      {
+        VecView<Lit> c = occManager->getClause(i);
+        for(int j = 0 ; j<c.size() ; j++) cnf.push(toInt(c[j]));
+        cnf.push(-1);
+      }
+      info.formulaSignature = hashMethod.hash((char *) (int *) cnf, cnf.size() * sizeof(int));
+    }
+
+    vec<double> wp;
+    for(int i = 0 ; i<s.nVars() ; i++)
+    {
+      wp.push(vs->isProjected(i) ? 1 : 0);
+      wp.push(weightLit[i<<1]);
+      wp.push(weightLit[(i<<1) | 1]);
+    }
+    info.weightSignature = hashMethod.hash((char *) (double *) wp, wp.size() * sizeof(double));
+  }// persistentCacheHeader
+
+
+  /**
+     Add the entries of a cache file (written by savePersistentCache
+     on the same problem) to the cache. The file is rejected if the
+     run is not compatible.
+
+     @param[in] fileName, the cache file
+   */
+  void loadPersistentCache(const char *fileName)
+  {
+    PersistentCacheHeader info;
+    const char *reason = NULL;
+    persistentCacheHeader(info);
+
+    long int nb = cache->loadPersistent(fileName, info, reason);
+    if(nb < 0) printf("c The cache file %s is rejected: %s\n", fileName, reason);
+    else printf("c %ld entries loaded from the cache file %s\n", nb, fileName);
+  }// loadPersistentCache
+
+
+  /**
+     Write the entries of the cache in a file.
+
+     @param[in] fileName, the cache file
+   */
+  void savePersistentCache(const char *fileName)
+  {
+    PersistentCacheHeader info;
+    persistentCacheHeader(info);
+
+    if(cache->savePersistent(fileName, info)) printf("c %lu entries saved in the cache file %s\n", info.nbEntry, fileName);
+    else printf("c WARNING! Could not write the cache file %s\n", fileName);
+  }// savePersistentCache
+
+
   /**
      Initialize the assumption in order to compute the number of model
      under this one.
@@ -397,6 +663,88 @@ public:
   }// initAssumption
 
 
+  /**
+     Select the literal used to split the search space under the given
+     assumption (the same choice computeDecisionNode would do at this
+     point).
+
+     @param[in] assums, the assumption
+     \return the literal to branch on, lit_Undef if the formula is
+     unsatisfiable under assums or if no variable remains to be assigned
+   */
+  Lit selectBranchingLiteral(vec<Lit> &assums)
+  {
+    initAssumption(assums);
+    if(!s.solveWithAssumptions()) return lit_Undef;
+
+    vec<Var> setOfVar;
+    vec<Lit> unitsLit;
+    for(int i = 0 ; i<s.nVars() ; i++) setOfVar.push(i);
+    s.collectUnit(setOfVar, unitsLit);
+
+    occManager->preUpdate(unitsLit);
+    occManager->updateCurrentClauseSet(setOfVar);
+    Var v = vs->selectVariable(setOfVar);
+    occManager->popPreviousClauseSet();
+    occManager->postUpdate(unitsLit);
+    s.cancelUntil(0);
+
+    if(v == var_Undef) return lit_Undef;
+    return mkLit(v, optReversePolarity - vs->selectPhase(v));
+  }// selectBranchingLiteral
+
+
+  /**
+     Create nbContext other model counters on the same formula, run by
+     their own thread, to which the large independent components are
+     given (see computeParallelComponents). All the contexts share the
+     cache of this counter.
+
+     @param[in] wl, the vector of literal's weight
+     @param[in] optList, the options
+     @param[in] isProjectedVar, boolean vector used to decide if a variable is projected (true) or not (false)
+     @param[in] nbContext, the number of contexts created
+   */
+  void initContextPool(vec<double> &wl, OptionManager &optList, vec<bool> &isProjectedVar, int nbContext)
+  {
+    vec<ModelCounter<T> *> contexts;
+    for(int i = 0 ; i<nbContext ; i++) contexts.push(new ModelCounter<T>(*this, wl, optList, isProjectedVar));
+    cache->setShared(true);
+
+    pool = new ContextPool<ModelCounter<T> >(contexts);
+    ownPool = true;
+    for(int i = 0 ; i<nbContext ; i++) pool->getContext(i)->pool = pool;
+  }// initContextPool
+
+
+  /**
+     Compute the number of models of a component given by another
+     counter: the solver and the occurrence manager are first put in
+     the state of the caller, described by the set of literals it has
+     assigned. Since the learnt clauses differ, this solver can
+     propagate more literals of the component than the caller, they
+     are handled as the unit literals of a regular call.
+
+     @param[in] context, the literals assigned by the caller
+     @param[in] component, the variables of the component
+     @param[in] priorityVar, select in priority these variable to the next decision node
+     \return the number of models of the component
+   */
+  T computeDetachedComponent(vec<Lit> &context, vec<Var> &component, vec<Var> &priorityVar)
+  {
+    vec<Var> currPriority;
+    priorityVar.copyTo(currPriority);
+
+    initAssumption(context);
+    occManager->preUpdate(context);
+    T ret = computeComponent(component, currPriority);
+    occManager->postUpdate(context);
+    s.cancelUntil(0);
+
+    return ret;
+  }// computeDetachedComponent
+
+
   /**
      Compute the number of model using the trace of a SAT solver.
 
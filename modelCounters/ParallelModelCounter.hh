@@ -0,0 +1,239 @@
+/*
+* d4
+* Copyright (C) 2020  Univ. Artois & CNRS
+* 
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef MODELCOUNTERS_PARALLELMODELCOUNTER_h
+#define MODELCOUNTERS_PARALLELMODELCOUNTER_h
+
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+#include "../modelCounters/ModelCounter.hh"
+#include "../utils/WorkStealingDeque.hh"
+#include "../utils/System.hh"
+#include "../utils/SolverTypes.hh"
+#include "../mtl/Vec.hh"
+
+#include "../manager/OptionManager.hh"
+
+#include <boost/multiprecision/gmp.hpp>
+using namespace boost::multiprecision;
+
+
+/**
+   Multi-threaded model counter.
+
+   The top of the decision tree (up to splitDepth decisions) is split
+   into tasks, a task being the set of decisions (a cube) leading to
+   a node of this tree. Each worker owns a model counter (solver,
+   occurrence manager) and a deque of tasks, the cache being shared
+   by all the workers: a task
+   under the split depth is expanded into its two children, the other
+   ones are counted sequentially under their cube. An idle worker
+   steals the oldest task of another worker, and sleeps when there is
+   nothing to steal until a task is pushed or the last task is done.
+   The final count is the sum of the counts of the leaves of the split
+   tree.
+ */
+template <class T> class ParallelModelCounter
+{
+private:
+  typedef std::vector<Lit> Cube;
+
+  int nbThreads, splitDepth;
+  vec<ModelCounter<T> *> workers;
+  WorkStealingDeque<Cube> *deques;
+  std::atomic<int> nbPendingTask;
+
+  // the idle workers wait for a new task (nbPush changes) or the end
+  std::mutex idleLock;
+  std::condition_variable idleCv;
+  std::atomic<unsigned> nbPush;
+
+  std::vector<T> partialCount;
+  vec<int> nbTask, nbSteal;
+
+  /**
+     Get a task for the worker id: its own last task if any, otherwise
+     the oldest task of another worker.
+
+     @param[in] id, the worker
+     @param[out] c, the task
+     \return true if a task has been found
+   */
+  inline bool getTask(int id, Cube &c)
+  {
+    if(deques[id].pop(c)) return true;
+
+    for(int i = 1 ; i<nbThreads ; i++)
+      if(deques[(id + i) % nbThreads].steal(c))
+        {
+          nbSteal[id]++;
+          return true;
+        }
+    return false;
+  }// getTask
+
+
+  /**
+     Wake up the idle workers.
+
+     @param[in] pushed, true if tasks have been pushed, false if the last task is done
+   */
+  inline void wakeUp(bool pushed)
+  {
+    {
+      std::lock_guard<std::mutex> guard(idleLock);
+      if(pushed) nbPush++;
+    }
+    idleCv.notify_all();
+  }// wakeUp
+
+
+  /**
+     The loop run by each worker, it stops when no task is pending
+     (waiting in a deque or being processed).
+
+     @param[in] id, the worker
+   */
+  void runWorker(int id)
+  {
+    ModelCounter<T> *mc = workers[id];
+    vec<Lit> assums;
+    Cube c;
+
+    while(nbPendingTask.load())
+      {
+        unsigned seen = nbPush.load();
+        if(!getTask(id, c))
+          {
+            std::unique_lock<std::mutex> guard(idleLock);
+            idleCv.wait(guard, [this, seen]{ return nbPush.load() != seen || !nbPendingTask.load(); });
+            continue;
+          }
+        nbTask[id]++;
+
+        assums.clear();
+        for(unsigned i = 0 ; i<c.size() ; i++) assums.push(c[i]);
+
+        Lit l = ((int) c.size() < splitDepth) ? mc->selectBranchingLiteral(assums) : lit_Undef;
+        if(l != lit_Undef)
+          {
+            nbPendingTask += 2;
+            c.push_back(~l);
+            deques[id].push(c);
+            c.back() = l;
+            deques[id].push(c);
+            wakeUp(true);
+          }
+        else
+          {
+            mc->initAssumption(assums);
+            partialCount[id] += mc->computeNbModel(false);
+          }
+
+        if(!--nbPendingTask) wakeUp(false);
+      }
+  }// runWorker
+
+
+  inline void printFinalStats(double startTime)
+  {
+    printf("c\nc \033[1m\033[31mStatistics \033[0m\n");
+    printf("c \033[33mParallel Model Counter Information\033[0m\n");
+    printf("c Number of threads: %d\n", nbThreads);
+    printf("c Split depth: %d\n", splitDepth);
+    printf("c %6s | %10s | %10s | %10s | %10s |\n", "worker", "#task", "#steal", "#call", "#Dec. Node");
+    for(int i = 0 ; i<nbThreads ; i++)
+      printf("c %6d | %10d | %10d | %10d | %10u |\n", i, nbTask[i], nbSteal[i],
+             workers[i]->getNbCall(), workers[i]->getNbDecisionNode());
+    printf("c\n");
+    workers[0]->getCache()->printCacheInformation();
+    printf("c Counting time: %lf\n", cpuTime() - startTime);
+    printf("c Final time: %lf\n", cpuTime());
+    printf("c \n");
+  }// printFinalStats
+
+public:
+  /**
+     Constructor of the parallel model counter.
+
+     @param[in] cnf, set of clauses
+     @param[in] wl, the vector of literal's weight
+     @param[in] optList, the options (nbThreads and splitDepth are used here)
+     @param[in] isProjectedVar, boolean vector used to decide if a variable is projected (true) or not (false)
+   */
+  ParallelModelCounter(vec<vec<Lit> > &cnf, vec<double> &wl, OptionManager &optList, vec<bool> &isProjectedVar)
+  {
+    nbThreads = optList.nbThreads;
+    splitDepth = optList.splitDepth;
+    if(!splitDepth) // a few tasks per thread to balance the load
+      {
+        splitDepth = 2;
+        while((1 << (splitDepth - 2)) < nbThreads) splitDepth++;
+      }
+
+    // the other workers are built on the simplified formula of the first one and share its cache
+    workers.push(new ModelCounter<T>(cnf, wl, optList, isProjectedVar));
+    for(int i = 1 ; i<nbThreads ; i++) workers.push(new ModelCounter<T>(*workers[0], wl, optList, isProjectedVar));
+    if(nbThreads > 1) workers[0]->getCache()->setShared(true);
+
+    deques = new WorkStealingDeque<Cube>[nbThreads];
+    partialCount.resize(nbThreads, T(0));
+    nbTask.initialize(nbThreads, 0);
+    nbSteal.initialize(nbThreads, 0);
+    nbPendingTask = 0;
+    nbPush = 0;
+  }// ParallelModelCounter
+
+  ~ParallelModelCounter()
+  {
+    for(int i = 0 ; i<workers.size() ; i++) delete workers[i];
+    delete[] deques;
+  }
+
+  inline void loadPersistentCache(const char *fileName){workers[0]->loadPersistentCache(fileName);}
+  inline void savePersistentCache(const char *fileName){workers[0]->savePersistentCache(fileName);}
+
+  /**
+     Compute the number of models using nbThreads workers.
+
+     \return the number of models
+   */
+  T computeNbModel()
+  {
+    double startTime = cpuTime();
+
+    nbPendingTask = 1;
+    deques[0].push(Cube());
+
+    std::vector<std::thread> pool;
+    for(int i = 1 ; i<nbThreads ; i++) pool.push_back(std::thread(&ParallelModelCounter<T>::runWorker, this, i));
+    runWorker(0);
+    for(unsigned i = 0 ; i<pool.size() ; i++) pool[i].join();
+
+    T ret = 0;
+    for(int i = 0 ; i<nbThreads ; i++) ret += partialCount[i];
+
+    printFinalStats(startTime);
+    return ret;
+  }// computeNbModel
+};
+
+#endif
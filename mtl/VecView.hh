@@ -0,0 +1,54 @@
+/*
+* d4
+* Copyright (C) 2020  Univ. Artois & CNRS
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef MTL_VEC_VIEW
+#define MTL_VEC_VIEW
+
+#include <assert.h>
+
+#include "../mtl/Vec.hh"
+
+/**
+   A part of an array owned by someone else (a clause or an occurrence
+   list of the occurrence manager). It is only valid while the owner
+   is not resized.
+ */
+template<class T>
+class VecView
+{
+  T *data;
+  int sz;
+
+public:
+  VecView() : data(NULL), sz(0) {}
+  VecView(T *d, int s) : data(d), sz(s) {}
+
+  inline int size() const {return sz;}
+  inline T &operator[](int i){assert(i >= 0 && i < sz); return data[i];}
+  inline const T &operator[](int i) const {assert(i >= 0 && i < sz); return data[i];}
+  inline T &last(){return data[sz - 1];}
+  inline operator T *(){return data;}
+
+  inline void copyTo(vec<T> &copy) const
+  {
+    copy.clear();
+    copy.growTo(sz);
+    for(int i = 0 ; i<sz ; i++) copy[i] = data[i];
+  }// copyTo
+};
+
+#endif
@@ -0,0 +1,162 @@
+/*
+* d4
+* Copyright (C) 2020  Univ. Artois & CNRS
+* 
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef UTILS_CONTEXT_POOL_h
+#define UTILS_CONTEXT_POOL_h
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <vector>
+
+#include "../mtl/Vec.hh"
+
+/**
+   A set of working contexts (a model counter or a compiler with its
+   own solver, occurrence manager and cache), each one attached to a
+   thread waiting for a job. A job is only given to an idle context
+   (tryLaunch never blocks), and the caller waits for the jobs it
+   launched. Since a job only waits for the jobs it launched itself,
+   nested launches cannot deadlock.
+ */
+template <class Context> class ContextPool
+{
+private:
+  struct Worker
+  {
+    Context *ctx;
+    std::thread th;
+    std::mutex lock;
+    std::condition_variable cv;
+    std::function<void(Context *)> job;
+    bool hasJob, done, stop;
+  };
+
+  std::mutex lockIdle;
+  std::vector<Worker *> workers;
+  vec<int> idle;
+  int nbLaunch;
+
+  void run(Worker *w)
+  {
+    std::unique_lock<std::mutex> guard(w->lock);
+    while(true)
+      {
+        w->cv.wait(guard, [w]{ return w->hasJob || w->stop; });
+        if(w->stop) return;
+
+        guard.unlock();
+        w->job(w->ctx);
+        guard.lock();
+
+        w->hasJob = false;
+        w->done = true;
+        w->cv.notify_all();
+      }
+  }// run
+
+public:
+  /**
+     Start one thread per context. The pool takes the ownership of the
+     contexts.
+
+     @param[in] ctxs, the contexts
+   */
+  ContextPool(vec<Context *> &ctxs)
+  {
+    nbLaunch = 0;
+    for(int i = 0 ; i<ctxs.size() ; i++)
+      {
+        Worker *w = new Worker();
+        w->ctx = ctxs[i];
+        w->hasJob = w->done = w->stop = false;
+        workers.push_back(w);
+        idle.push(i);
+      }
+
+    for(unsigned i = 0 ; i<workers.size() ; i++)
+      workers[i]->th = std::thread(&ContextPool<Context>::run, this, workers[i]);
+  }// constructor
+
+  ~ContextPool()
+  {
+    for(unsigned i = 0 ; i<workers.size() ; i++)
+      {
+        {
+          std::lock_guard<std::mutex> guard(workers[i]->lock);
+          workers[i]->stop = true;
+        }
+        workers[i]->cv.notify_all();
+        workers[i]->th.join();
+        delete workers[i]->ctx;
+        delete workers[i];
+      }
+  }// destructor
+
+  inline int size(){return workers.size();}
+  inline int getNbLaunch(){return nbLaunch;}
+  inline Context *getContext(int i){return workers[i]->ctx;}
+
+  /**
+     Give a job to an idle context.
+
+     @param[in] job, the function run on the context
+     \return the index of the worker running the job, -1 if every context is busy
+   */
+  int tryLaunch(std::function<void(Context *)> job)
+  {
+    int idx = -1;
+    {
+      std::lock_guard<std::mutex> guard(lockIdle);
+      if(!idle.size()) return -1;
+      idx = idle.last();
+      idle.pop();
+      nbLaunch++;
+    }
+
+    Worker *w = workers[idx];
+    {
+      std::lock_guard<std::mutex> guard(w->lock);
+      w->job = job;
+      w->done = false;
+      w->hasJob = true;
+    }
+    w->cv.notify_all();
+    return idx;
+  }// tryLaunch
+
+  /**
+     Wait for the end of the job launched on the worker idx and give
+     the context back to the pool.
+
+     @param[in] idx, the value returned by tryLaunch
+   */
+  void wait(int idx)
+  {
+    Worker *w = workers[idx];
+    {
+      std::unique_lock<std::mutex> guard(w->lock);
+      w->cv.wait(guard, [w]{ return w->done; });
+    }
+
+    std::lock_guard<std::mutex> guard(lockIdle);
+    idle.push(idx);
+  }// wait
+};
+
+#endif
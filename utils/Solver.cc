@@ -262,7 +262,6 @@ bool Solver::addClause_(vec<Lit>& ps)
 
 void Solver::collectUnit(vec<Var> &setOfVar, vec<Lit> &unitsLit, Lit dec)
 {
-  static int cpt = 0;
   unitsLit.clear();
   if(dec != lit_Undef) unitsLit.push(dec);
 
@@ -63,9 +63,8 @@ static inline double cpuTime(void) { return (double)clock() / CLOCKS_PER_SEC; }
 #include <unistd.h>
 
 
-static struct timeval initTime;
-
 static inline double init_wall_time(){  
+  struct timeval initTime;
   gettimeofday(&initTime,NULL);
   return (double) initTime.tv_sec + (double)initTime.tv_usec * .000001;
 }
@@ -75,8 +74,9 @@ static inline double cpuTime(void)
 {
   static double start_wall_time = init_wall_time();
 
-  gettimeofday(&initTime, NULL);
-  double current_wall_time = (double)initTime.tv_sec + (double)initTime.tv_usec * .000001;
+  struct timeval currTime; // local, cpuTime is called concurrently by the parallel model counter
+  gettimeofday(&currTime, NULL);
+  double current_wall_time = (double)currTime.tv_sec + (double)currTime.tv_usec * .000001;
   double result = current_wall_time-start_wall_time;
   return result; 
 }
@@ -0,0 +1,74 @@
+/*
+* d4
+* Copyright (C) 2020  Univ. Artois & CNRS
+* 
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+* 
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+* 
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef UTILS_WORK_STEALING_DEQUE_h
+#define UTILS_WORK_STEALING_DEQUE_h
+
+#include <deque>
+#include <mutex>
+
+/**
+   Double ended queue of tasks owned by one worker. The owner pushes
+   and pops at the back (depth first, good locality), the other workers
+   steal at the front, where the oldest (and so the biggest) subtrees
+   are.
+ */
+template <class Task> class WorkStealingDeque
+{
+private:
+  std::mutex lock;
+  std::deque<Task> tasks;
+
+public:
+  inline void push(const Task &t)
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    tasks.push_back(t);
+  }// push
+
+  /**
+     Take the last pushed task (owner side).
+
+     @param[out] t, the task
+     \return false if the deque is empty
+   */
+  inline bool pop(Task &t)
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    if(tasks.empty()) return false;
+    t = tasks.back();
+    tasks.pop_back();
+    return true;
+  }// pop
+
+  /**
+     Take the oldest task (thief side).
+
+     @param[out] t, the task
+     \return false if the deque is empty
+   */
+  inline bool steal(Task &t)
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    if(tasks.empty()) return false;
+    t = tasks.front();
+    tasks.pop_front();
+    return true;
+  }// steal
+};
+
+#endif